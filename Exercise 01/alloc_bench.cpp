@@ -0,0 +1,201 @@
+// OS 24 EX1
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "memory_latency.h"
+#include "allocators.h"
+#include "alloc_bench.h"
+
+#define PROC_STATM_PATH "/proc/self/statm"
+#define TOUCH_STRIDE 4096
+
+static const AllocatorKind benchmarked_allocators[] = {AllocatorKind::MALLOC, AllocatorKind::MMAP,
+                                                       AllocatorKind::BUMP_ARENA, AllocatorKind::SIZE_CLASS_POOL};
+
+/**
+ * The work of a single benchmark thread.
+ */
+struct alloc_worker {
+    Allocator *allocator;
+    const std::vector<uint64_t> *sizes; // The sizes to draw from, a single size for the 'fixed' distribution.
+    uint64_t ops;
+    uint64_t batch;
+    uint64_t seed;
+    bool failed;
+};
+
+/**
+ * Reads the resident set size of the process.
+ * @return the resident set size in bytes, or 0 if it could not be read.
+ */
+uint64_t resident_set_bytes() {
+    FILE *statm = fopen(PROC_STATM_PATH, "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long long size = 0, resident = 0;
+    int read = fscanf(statm, "%llu %llu", &size, &resident);
+    fclose(statm);
+    return read == 2 ? resident * (uint64_t) sysconf(_SC_PAGESIZE) : 0;
+}
+
+/**
+ * Allocates, touches and releases batches of blocks.
+ * @param worker - the work description.
+ * @param ready - incremented once the thread is ready to start.
+ * @param go - spun on until the main thread starts the clock.
+ */
+static void run_alloc_worker(struct alloc_worker *worker, std::atomic<int> *ready, std::atomic<bool> *go) {
+    std::vector<void *> blocks(worker->batch);
+    std::vector<uint64_t> block_sizes(worker->batch);
+    uint64_t rnd = worker->seed;
+
+    ready->fetch_add(1);
+    while (!go->load(std::memory_order_acquire)) {}
+
+    for (uint64_t done = 0; done < worker->ops;) {
+        uint64_t count = worker->ops - done < worker->batch ? worker->ops - done : worker->batch;
+        for (uint64_t i = 0; i < count; i++) {
+            block_sizes[i] = (*worker->sizes)[rnd % worker->sizes->size()];
+            rnd = (rnd >> 1) ^ ((0 - (rnd & 1)) & GALOIS_POLYNOMIAL);  // Advance rnd pseudo-randomly (Galois LFSR)
+            char *block = static_cast<char *>(worker->allocator->allocate(block_sizes[i]));
+            if (block == nullptr) {
+                worker->failed = true;
+                return;
+            }
+            for (uint64_t offset = 0; offset < block_sizes[i]; offset += TOUCH_STRIDE) {
+                block[offset] = (char) offset;
+            }
+            blocks[i] = block;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            worker->allocator->release(blocks[i], block_sizes[i]);
+        }
+        worker->allocator->endBatch();
+        done += count;
+    }
+}
+
+/**
+ * Runs one configuration of the allocator benchmark and prints its result line.
+ * @param kind - the allocator.
+ * @param distribution - the name of the size distribution.
+ * @param size - the largest block size of the configuration.
+ * @param sizes - the sizes to draw from.
+ * @param threads - the number of threads.
+ * @param ops - the number of allocate/release pairs every thread performs.
+ * @param batch - the number of blocks every thread keeps allocated at once.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int run_alloc_config(AllocatorKind kind, const char *distribution, uint64_t size,
+                            const std::vector<uint64_t> &sizes, int threads, uint64_t ops, uint64_t batch) {
+    std::vector<struct alloc_worker> workers(threads);
+    for (int i = 0; i < threads; i++) {
+        workers[i] = alloc_worker{create_allocator(kind), &sizes, ops, batch, 12345ull + i, false};
+    }
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+
+    uint64_t rss_before = resident_set_bytes();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(run_alloc_worker, &workers[i], &ready, &go);
+    }
+    while (ready.load() != threads) {}
+
+    struct rusage usage_before;
+    getrusage(RUSAGE_SELF, &usage_before);
+    struct timespec t0;
+    timespec_get(&t0, TIME_UTC);
+    go.store(true, std::memory_order_release);
+    for (std::thread &thread: pool) {
+        thread.join();
+    }
+    struct timespec t1;
+    timespec_get(&t1, TIME_UTC);
+    struct rusage usage_after;
+    getrusage(RUSAGE_SELF, &usage_after);
+    // Measured before the allocators are destroyed, so memory they cache counts as growth.
+    uint64_t rss_after = resident_set_bytes();
+
+    bool failed = false;
+    for (struct alloc_worker &worker: workers) {
+        failed |= worker.failed;
+        delete worker.allocator;
+    }
+    if (failed) {
+        std::cerr << allocator_name(kind) << " failed to allocate " << size << " bytes" << std::endl;
+        return -1;
+    }
+
+    double seconds = (double) (nanosectime(t1) - nanosectime(t0)) / 1e9;
+    std::cout << allocator_name(kind) << "," << distribution << "," << size << "," << threads << ","
+              << (double) (ops * threads) / seconds << ","
+              << (int64_t) (rss_after - rss_before) << ","
+              << usage_after.ru_minflt - usage_before.ru_minflt << ","
+              << usage_after.ru_majflt - usage_before.ru_majflt << "\n";
+    return 0;
+}
+
+/**
+ * Runs the allocator benchmark, comparing glibc malloc, mmap, a bump arena and a size-class pool.
+ * @param argc - the number of arguments following '--alloc-bench'.
+ * @param argv - the arguments following '--alloc-bench'.
+ * @return the process exit code.
+ */
+int run_alloc_bench(int argc, char *argv[]) {
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Wrong number of arguments was given, Usage: --alloc-bench max_size factor max_threads ops"
+                  << " [batch]" << std::endl;
+        return 1;
+    }
+
+    char *end;
+    uint64_t max_size = strtoull(argv[0], &end, 10);
+    if (*end != '\0' || max_size < STARTING_SIZE) {
+        std::cerr << "Invalid max_size argument." << std::endl;
+        return 1;
+    }
+    double factor = strtod(argv[1], &end);
+    if (*end != '\0' || factor <= 1) {
+        std::cerr << "Invalid factor argument." << std::endl;
+        return 1;
+    }
+    long max_threads = strtol(argv[2], &end, 10);
+    if (*end != '\0' || max_threads <= 0) {
+        std::cerr << "Invalid max_threads argument." << std::endl;
+        return 1;
+    }
+    uint64_t ops = strtoull(argv[3], &end, 10);
+    if (*end != '\0' || ops == 0) {
+        std::cerr << "Invalid ops argument." << std::endl;
+        return 1;
+    }
+    uint64_t batch = ALLOC_BENCH_DEFAULT_BATCH;
+    if (argc == 5) {
+        batch = strtoull(argv[4], &end, 10);
+        if (*end != '\0' || batch == 0) {
+            std::cerr << "Invalid batch argument." << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<uint64_t> mixed_sizes;
+    for (uint64_t size = STARTING_SIZE; size <= max_size; size = next_geometric_size(size, factor)) {
+        mixed_sizes.push_back(size);
+        std::vector<uint64_t> fixed_sizes(1, size);
+        for (AllocatorKind kind: benchmarked_allocators) {
+            for (int threads = 1; threads <= max_threads; threads++) {
+                if (run_alloc_config(kind, "fixed", size, fixed_sizes, threads, ops, batch) != 0 ||
+                    run_alloc_config(kind, "mixed", size, mixed_sizes, threads, ops, batch) != 0) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
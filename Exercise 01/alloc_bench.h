@@ -0,0 +1,35 @@
+// OS 24 EX1
+
+#ifndef _ALLOC_BENCH_H
+#define _ALLOC_BENCH_H
+
+#include <stdint.h>
+
+#define ALLOC_BENCH_DEFAULT_BATCH 64
+
+/**
+ * Reads the resident set size of the process.
+ * @return the resident set size in bytes, or 0 if it could not be read.
+ */
+uint64_t resident_set_bytes();
+
+
+/**
+ * Runs the allocator benchmark, comparing glibc malloc, mmap, a bump arena and a size-class pool.
+ * Usage: './memory_latency --alloc-bench max_size factor max_threads ops [batch]' where:
+ *      - max_size, factor - the block sizes, iterated geometrically from STARTING_SIZE like the latency sweep.
+ *      - max_threads - every configuration is run with 1, 2, ..., max_threads threads.
+ *      - ops - the number of allocate/release pairs every thread performs.
+ *      - batch - the number of blocks every thread keeps allocated at once before releasing them.
+ * Every size is run with a 'fixed' distribution (all blocks of that size) and a 'mixed' one (blocks drawn from all
+ * the geometric sizes up to that size). Every allocated block is touched once per page.
+ * The program will print output to stdout in the following format:
+ *      allocator,distribution,size,threads,pairs_per_second,rss_growth_bytes,minor_faults,major_faults
+ * @param argc - the number of arguments following '--alloc-bench'.
+ * @param argv - the arguments following '--alloc-bench'.
+ * @return the process exit code.
+ */
+int run_alloc_bench(int argc, char *argv[]);
+
+
+#endif
@@ -0,0 +1,181 @@
+// OS 24 EX1
+
+#include <cstdlib>
+#include <sys/mman.h>
+#include "allocators.h"
+
+#define ARENA_CHUNK_SIZE (64ull << 20)
+#define ARENA_ALIGNMENT 16
+#define POOL_MIN_CLASS_SIZE 16
+#define POOL_MAX_CLASS_SIZE (256ull << 10)
+#define POOL_SLAB_SIZE (1ull << 20)
+#define POOL_MIN_BLOCKS_PER_SLAB 8
+
+/**
+ * Maps anonymous memory.
+ * @param size - the size of the mapping.
+ * @return the mapping, or nullptr on failure.
+ */
+static void *map_anonymous(size_t size) {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+void *MallocAllocator::allocate(size_t size) {
+    return malloc(size);
+}
+
+void MallocAllocator::release(void *ptr, size_t size) {
+    (void) size;
+    free(ptr);
+}
+
+void *MmapAllocator::allocate(size_t size) {
+    return map_anonymous(size);
+}
+
+void MmapAllocator::release(void *ptr, size_t size) {
+    munmap(ptr, size);
+}
+
+BumpArenaAllocator::~BumpArenaAllocator() {
+    for (const Chunk &chunk: chunks) {
+        munmap(chunk.base, chunk.size);
+    }
+}
+
+void *BumpArenaAllocator::allocate(size_t size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+    while (currentChunk < chunks.size() && offset + size > chunks[currentChunk].size) {
+        currentChunk++;
+        offset = 0;
+    }
+    if (currentChunk == chunks.size()) {
+        size_t chunkSize = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        void *base = map_anonymous(chunkSize);
+        if (base == nullptr) {
+            return nullptr;
+        }
+        chunks.push_back(Chunk{static_cast<char *>(base), chunkSize});
+        offset = 0;
+    }
+    void *ptr = chunks[currentChunk].base + offset;
+    offset += size;
+    return ptr;
+}
+
+void BumpArenaAllocator::release(void *ptr, size_t size) {
+    (void) ptr;
+    (void) size;
+}
+
+void BumpArenaAllocator::endBatch() {
+    currentChunk = 0;
+    offset = 0;
+}
+
+SizeClassPoolAllocator::SizeClassPoolAllocator() : freeLists(sizeClass(POOL_MAX_CLASS_SIZE) + 1, nullptr) {}
+
+SizeClassPoolAllocator::~SizeClassPoolAllocator() {
+    for (const auto &slab: slabs) {
+        munmap(slab.first, slab.second);
+    }
+}
+
+/**
+ * @brief Maps a size to the index of the smallest size class that fits it.
+ * @param size the requested size.
+ * @return the size class index.
+ */
+size_t SizeClassPoolAllocator::sizeClass(size_t size) {
+    size_t index = 0;
+    while (((size_t) POOL_MIN_CLASS_SIZE << index) < size) {
+        index++;
+    }
+    return index;
+}
+
+/**
+ * @brief Carves a new slab into free blocks of a size class.
+ * @param sizeClassIndex the size class to refill.
+ * @return true on success and false if the slab could not be mapped.
+ */
+bool SizeClassPoolAllocator::refill(size_t sizeClassIndex) {
+    size_t blockSize = (size_t) POOL_MIN_CLASS_SIZE << sizeClassIndex;
+    size_t slabSize = blockSize * POOL_MIN_BLOCKS_PER_SLAB > POOL_SLAB_SIZE ?
+                      blockSize * POOL_MIN_BLOCKS_PER_SLAB : POOL_SLAB_SIZE;
+    char *slab = static_cast<char *>(map_anonymous(slabSize));
+    if (slab == nullptr) {
+        return false;
+    }
+    slabs.emplace_back(slab, slabSize);
+    // Link the blocks from the end, so they are handed out in address order.
+    for (size_t offset = slabSize; offset >= blockSize; offset -= blockSize) {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + offset - blockSize);
+        block->next = freeLists[sizeClassIndex];
+        freeLists[sizeClassIndex] = block;
+    }
+    return true;
+}
+
+void *SizeClassPoolAllocator::allocate(size_t size) {
+    if (size > POOL_MAX_CLASS_SIZE) {
+        return map_anonymous(size);
+    }
+    size_t index = sizeClass(size);
+    if (freeLists[index] == nullptr && !refill(index)) {
+        return nullptr;
+    }
+    FreeBlock *block = freeLists[index];
+    freeLists[index] = block->next;
+    return block;
+}
+
+void SizeClassPoolAllocator::release(void *ptr, size_t size) {
+    if (size > POOL_MAX_CLASS_SIZE) {
+        munmap(ptr, size);
+        return;
+    }
+    size_t index = sizeClass(size);
+    FreeBlock *block = static_cast<FreeBlock *>(ptr);
+    block->next = freeLists[index];
+    freeLists[index] = block;
+}
+
+/**
+ * Creates an allocator.
+ * @param kind - the allocator to create.
+ * @return a new allocator, owned by the caller.
+ */
+Allocator *create_allocator(AllocatorKind kind) {
+    switch (kind) {
+        case AllocatorKind::MALLOC:
+            return new MallocAllocator();
+        case AllocatorKind::MMAP:
+            return new MmapAllocator();
+        case AllocatorKind::BUMP_ARENA:
+            return new BumpArenaAllocator();
+        case AllocatorKind::SIZE_CLASS_POOL:
+            return new SizeClassPoolAllocator();
+    }
+    return nullptr;
+}
+
+/**
+ * Returns the name of an allocator, as printed by the benchmark.
+ * @param kind - the allocator.
+ * @return the name.
+ */
+const char *allocator_name(AllocatorKind kind) {
+    switch (kind) {
+        case AllocatorKind::MALLOC:
+            return "malloc";
+        case AllocatorKind::MMAP:
+            return "mmap";
+        case AllocatorKind::BUMP_ARENA:
+            return "bump_arena";
+        case AllocatorKind::SIZE_CLASS_POOL:
+            return "size_class_pool";
+    }
+    return "unknown";
+}
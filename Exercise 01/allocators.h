@@ -0,0 +1,132 @@
+// OS 24 EX1
+
+#ifndef _ALLOCATORS_H
+#define _ALLOCATORS_H
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * The allocators compared by the allocator benchmark.
+ */
+enum class AllocatorKind {
+    MALLOC,
+    MMAP,
+    BUMP_ARENA,
+    SIZE_CLASS_POOL
+};
+
+/**
+ * A minimal allocator interface. Every benchmark thread owns its own instance, so implementations don't have to be
+ * thread safe (malloc and mmap are anyway).
+ */
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+
+    /**
+     * @brief Allocates a block.
+     * @param size the size of the block in bytes.
+     * @return the block, or nullptr on failure.
+     */
+    virtual void *allocate(size_t size) = 0;
+
+    /**
+     * @brief Releases a block returned by allocate.
+     * @param ptr the block.
+     * @param size the size the block was allocated with.
+     */
+    virtual void release(void *ptr, size_t size) = 0;
+
+    /**
+     * @brief Called once all the blocks of a batch were released.
+     */
+    virtual void endBatch() {}
+};
+
+/**
+ * @brief Forwards to glibc malloc and free.
+ */
+class MallocAllocator : public Allocator {
+public:
+    void *allocate(size_t size) override;
+
+    void release(void *ptr, size_t size) override;
+};
+
+/**
+ * @brief Maps every block with its own anonymous mmap.
+ */
+class MmapAllocator : public Allocator {
+public:
+    void *allocate(size_t size) override;
+
+    void release(void *ptr, size_t size) override;
+};
+
+/**
+ * @brief Hands out blocks by bumping a pointer through mmap'd chunks. Releasing a block does nothing, the whole
+ * arena is rewound at the end of every batch.
+ */
+class BumpArenaAllocator : public Allocator {
+public:
+    ~BumpArenaAllocator() override;
+
+    void *allocate(size_t size) override;
+
+    void release(void *ptr, size_t size) override;
+
+    void endBatch() override;
+
+private:
+    struct Chunk {
+        char *base;
+        size_t size;
+    };
+    std::vector<Chunk> chunks;
+    size_t currentChunk = 0;
+    size_t offset = 0;
+};
+
+/**
+ * @brief Keeps a free list per power-of-two size class, refilled by carving mmap'd slabs. Blocks larger than the
+ * largest class are mapped directly. Memory is never returned to the system before destruction.
+ */
+class SizeClassPoolAllocator : public Allocator {
+public:
+    SizeClassPoolAllocator();
+
+    ~SizeClassPoolAllocator() override;
+
+    void *allocate(size_t size) override;
+
+    void release(void *ptr, size_t size) override;
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+    std::vector<FreeBlock *> freeLists;
+    std::vector<std::pair<void *, size_t>> slabs;
+
+    static size_t sizeClass(size_t size);
+
+    bool refill(size_t sizeClassIndex);
+};
+
+/**
+ * Creates an allocator.
+ * @param kind - the allocator to create.
+ * @return a new allocator, owned by the caller.
+ */
+Allocator *create_allocator(AllocatorKind kind);
+
+/**
+ * Returns the name of an allocator, as printed by the benchmark.
+ * @param kind - the allocator.
+ * @return the name.
+ */
+const char *allocator_name(AllocatorKind kind);
+
+
+#endif
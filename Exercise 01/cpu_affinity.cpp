@@ -0,0 +1,216 @@
+// OS 24 EX1
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include "cpu_affinity.h"
+
+#define PROC_STAT_PATH "/proc/stat"
+#define PROC_STAT_LINE_LENGTH 512
+#define CPU_SYSFS_PREFIX "/sys/devices/system/cpu/cpu"
+#define CPU_SOCKET_SUFFIX "/topology/physical_package_id"
+#define NODE_SYSFS_DIR "/sys/devices/system/node"
+
+/**
+ * Returns the number of online cpus.
+ * @return the number of online cpus (at least 1).
+ */
+int online_cpu_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count < 1 ? 1 : (int) count;
+}
+
+/**
+ * Returns the cpus the calling thread may run on, its affinity mask as restricted by taskset, cpusets or a container.
+ * @param cpus - receives the allowed cpus, in increasing order.
+ * @return 0 on success, -1 on failure.
+ */
+int allowed_cpus(std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return -1;
+    }
+    cpus.clear();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Pins the calling thread to a single cpu.
+ * @param cpu - the cpu to pin to.
+ * @return 0 on success, -1 on failure.
+ */
+int pin_thread_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+/**
+ * Pins the calling thread to a set of cpus.
+ * @param cpus - the cpus to pin to.
+ * @return 0 on success, -1 on failure.
+ */
+int pin_thread_to_cpus(const std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu: cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+/**
+ * Parses a kernel cpu list, such as "0-3,8,10-11".
+ * @param list - the cpu list.
+ * @param cpus - receives the cpus.
+ * @return 0 on success, -1 on a malformed list.
+ */
+int parse_cpu_list(const std::string &list, std::vector<int> &cpus) {
+    cpus.clear();
+    const char *cursor = list.c_str();
+    while (*cursor != '\0' && *cursor != '\n') {
+        char *end;
+        long first = strtol(cursor, &end, 10);
+        long last = first;
+        if (end == cursor || first < 0) {
+            return -1;
+        }
+        if (*end == '-') {
+            cursor = end + 1;
+            last = strtol(cursor, &end, 10);
+            if (end == cursor || last < first) {
+                return -1;
+            }
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back((int) cpu);
+        }
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return 0;
+}
+
+/**
+ * Returns the socket (physical package) a cpu belongs to.
+ * @param cpu - the cpu.
+ * @return the socket id, or 0 if the topology is not available.
+ */
+int cpu_socket(int cpu) {
+    std::ifstream file(CPU_SYSFS_PREFIX + std::to_string(cpu) + CPU_SOCKET_SUFFIX);
+    int socket = 0;
+    return file >> socket ? socket : 0;
+}
+
+/**
+ * Reads the NUMA nodes of the host and the cpus of each.
+ * @param nodes - receives the cpus of every node, indexed by the node id (nodes without cpus are left empty).
+ *      A host without NUMA information is reported as a single node 0 with all the online cpus.
+ * @return 0 on success, -1 on failure.
+ */
+int read_numa_nodes(std::vector<std::vector<int>> &nodes) {
+    nodes.clear();
+    DIR *dir = opendir(NODE_SYSFS_DIR);
+    if (dir != nullptr) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            int node;
+            if (sscanf(entry->d_name, "node%d", &node) != 1 || node < 0) {
+                continue;
+            }
+            std::ifstream file(std::string(NODE_SYSFS_DIR "/") + entry->d_name + "/cpulist");
+            std::string list;
+            std::vector<int> cpus;
+            if (!std::getline(file, list) || parse_cpu_list(list, cpus) != 0) {
+                continue;
+            }
+            if ((size_t) node >= nodes.size()) {
+                nodes.resize(node + 1);
+            }
+            nodes[node] = cpus;
+        }
+        closedir(dir);
+    }
+    if (nodes.empty()) {
+        nodes.resize(1);
+        for (int cpu = 0; cpu < online_cpu_count(); cpu++) {
+            nodes[0].push_back(cpu);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Reads the per-cpu time counters from /proc/stat.
+ * @param times - filled with one entry per cpu, indexed by the cpu number.
+ * @return 0 on success, -1 on failure.
+ */
+int read_cpu_times(std::vector<struct cpu_times> &times) {
+    FILE *stat = fopen(PROC_STAT_PATH, "r");
+    if (stat == nullptr) {
+        return -1;
+    }
+    times.clear();
+    char line[PROC_STAT_LINE_LENGTH];
+    while (fgets(line, sizeof(line), stat) != nullptr) {
+        // Only the "cpuN ..." lines, the aggregated "cpu ..." line is skipped.
+        if (strncmp(line, "cpu", 3) != 0 || line[3] < '0' || line[3] > '9') {
+            continue;
+        }
+        int cpu;
+        unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        if (sscanf(line, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu", &cpu, &user, &nice, &system, &idle,
+                   &iowait, &irq, &softirq, &steal) < 5 || cpu < 0) {
+            continue;
+        }
+        if ((size_t) cpu >= times.size()) {
+            times.resize(cpu + 1, cpu_times{0, 0});
+        }
+        times[cpu].idle = idle + iowait;
+        times[cpu].total = user + nice + system + idle + iowait + irq + softirq + steal;
+    }
+    fclose(stat);
+    return times.empty() ? -1 : 0;
+}
+
+/**
+ * Picks the cpu that was the most idle between two /proc/stat snapshots, among a set of candidates.
+ * @param before - the older snapshot.
+ * @param after - the newer snapshot.
+ * @param candidates - the cpus to choose from (not empty), such as the ones returned by allowed_cpus.
+ * @return the most idle candidate, or the first candidate when the snapshots can not be compared.
+ */
+int find_idlest_cpu(const std::vector<struct cpu_times> &before, const std::vector<struct cpu_times> &after,
+                    const std::vector<int> &candidates) {
+    int best_cpu = candidates[0];
+    double best_idle = -1;
+    for (int cpu: candidates) {
+        if ((size_t) cpu >= before.size() || (size_t) cpu >= after.size()) {
+            continue;
+        }
+        uint64_t total = after[cpu].total - before[cpu].total;
+        if (after[cpu].total == 0 || total == 0) {
+            continue; // Offline, or no ticks passed yet.
+        }
+        double idle = (double) (after[cpu].idle - before[cpu].idle) / total;
+        if (idle > best_idle) {
+            best_idle = idle;
+            best_cpu = cpu;
+        }
+    }
+    return best_cpu;
+}
@@ -0,0 +1,95 @@
+// OS 24 EX1
+
+#ifndef _CPU_AFFINITY_H
+#define _CPU_AFFINITY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A snapshot of the per-cpu time counters of /proc/stat.
+ */
+struct cpu_times {
+    uint64_t idle;
+    uint64_t total;
+};
+
+
+/**
+ * Returns the number of online cpus.
+ * @return the number of online cpus (at least 1).
+ */
+int online_cpu_count();
+
+
+/**
+ * Returns the cpus the calling thread may run on, its affinity mask as restricted by taskset, cpusets or a container.
+ * @param cpus - receives the allowed cpus, in increasing order.
+ * @return 0 on success, -1 on failure.
+ */
+int allowed_cpus(std::vector<int> &cpus);
+
+
+/**
+ * Pins the calling thread to a single cpu.
+ * @param cpu - the cpu to pin to.
+ * @return 0 on success, -1 on failure.
+ */
+int pin_thread_to_cpu(int cpu);
+
+
+/**
+ * Pins the calling thread to a set of cpus.
+ * @param cpus - the cpus to pin to.
+ * @return 0 on success, -1 on failure.
+ */
+int pin_thread_to_cpus(const std::vector<int> &cpus);
+
+
+/**
+ * Parses a kernel cpu list, such as "0-3,8,10-11".
+ * @param list - the cpu list.
+ * @param cpus - receives the cpus.
+ * @return 0 on success, -1 on a malformed list.
+ */
+int parse_cpu_list(const std::string &list, std::vector<int> &cpus);
+
+
+/**
+ * Returns the socket (physical package) a cpu belongs to.
+ * @param cpu - the cpu.
+ * @return the socket id, or 0 if the topology is not available.
+ */
+int cpu_socket(int cpu);
+
+
+/**
+ * Reads the NUMA nodes of the host and the cpus of each.
+ * @param nodes - receives the cpus of every node, indexed by the node id (nodes without cpus are left empty).
+ *      A host without NUMA information is reported as a single node 0 with all the online cpus.
+ * @return 0 on success, -1 on failure.
+ */
+int read_numa_nodes(std::vector<std::vector<int>> &nodes);
+
+
+/**
+ * Reads the per-cpu time counters from /proc/stat.
+ * @param times - filled with one entry per cpu, indexed by the cpu number.
+ * @return 0 on success, -1 on failure.
+ */
+int read_cpu_times(std::vector<struct cpu_times> &times);
+
+
+/**
+ * Picks the cpu that was the most idle between two /proc/stat snapshots, among a set of candidates.
+ * @param before - the older snapshot.
+ * @param after - the newer snapshot.
+ * @param candidates - the cpus to choose from (not empty), such as the ones returned by allowed_cpus.
+ * @return the most idle candidate, or the first candidate when the snapshots can not be compared.
+ */
+int find_idlest_cpu(const std::vector<struct cpu_times> &before, const std::vector<struct cpu_times> &after,
+                    const std::vector<int> &candidates);
+
+
+#endif
@@ -0,0 +1,150 @@
+// OS 24 EX1
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "memory_latency.h"
+#include "cpu_affinity.h"
+#include "false_sharing.h"
+
+#define COUNTERS_ALIGNMENT 4096
+
+static const uint64_t default_distances[] = {FALSE_SHARING_SAME_LINE, FALSE_SHARING_ADJACENT_LINES,
+                                             FALSE_SHARING_LINE_PAIRS, FALSE_SHARING_PAGE_SEPARATED};
+
+/**
+ * Increments a counter. The counter is volatile so every increment is a load and a store to memory, which is
+ * exactly the traffic a shared per-thread statistics counter generates.
+ * @param counter - the counter of this thread.
+ * @param increments - the number of increments.
+ * @param cpu - the cpu to pin to.
+ * @param ready - incremented once the thread is ready to start.
+ * @param go - spun on until the main thread starts the clock.
+ * @param pin_failures - incremented if the thread could not be pinned to its cpu.
+ */
+static void run_counter_thread(volatile uint64_t *counter, uint64_t increments, int cpu, std::atomic<int> *ready,
+                               std::atomic<bool> *go, std::atomic<int> *pin_failures) {
+    if (pin_thread_to_cpu(cpu) != 0) {
+        pin_failures->fetch_add(1);
+    }
+    ready->fetch_add(1);
+    while (!go->load(std::memory_order_acquire)) {}
+    for (uint64_t i = 0; i < increments; i++) {
+        *counter = *counter + 1;
+    }
+}
+
+/**
+ * Runs a single layout with a given number of threads and prints its result line.
+ * @param distance - the byte distance between neighbouring counters.
+ * @param threads - the number of threads.
+ * @param increments - the number of increments every thread performs.
+ * @param cpus - the cpus the threads are pinned to, thread i to cpus[i % cpus.size()].
+ * @return 0 on success, -1 on allocation failure or if a thread could not be pinned.
+ */
+static int run_layout(uint64_t distance, int threads, uint64_t increments, const std::vector<int> &cpus) {
+    uint64_t bytes = (distance * threads + COUNTERS_ALIGNMENT - 1) & ~(uint64_t) (COUNTERS_ALIGNMENT - 1);
+    char *counters = static_cast<char *>(aligned_alloc(COUNTERS_ALIGNMENT, bytes));
+    if (counters == nullptr) {
+        std::cerr << "Malloc Failed" << std::endl;
+        return -1;
+    }
+    for (uint64_t offset = 0; offset < bytes; offset += sizeof(uint64_t)) {
+        *reinterpret_cast<uint64_t *>(counters + offset) = 0;
+    }
+
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<int> pin_failures(0);
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++) {
+        pool.emplace_back(run_counter_thread, reinterpret_cast<volatile uint64_t *>(counters + i * distance),
+                          increments, cpus[i % cpus.size()], &ready, &go, &pin_failures);
+    }
+    while (ready.load() != threads) {}
+
+    struct timespec t0;
+    timespec_get(&t0, TIME_UTC);
+    go.store(true, std::memory_order_release);
+    for (std::thread &thread: pool) {
+        thread.join();
+    }
+    struct timespec t1;
+    timespec_get(&t1, TIME_UTC);
+    free(counters);
+    if (pin_failures.load() != 0) {
+        std::cerr << "Failed to pin " << pin_failures.load() << " counter threads to their cpus." << std::endl;
+        return -1;
+    }
+
+    double seconds = (double) (nanosectime(t1) - nanosectime(t0)) / 1e9;
+    double total = (double) (increments * threads) / seconds;
+    std::cout << distance << "," << threads << "," << total << "," << total / threads << "\n";
+    return 0;
+}
+
+/**
+ * Runs the false-sharing benchmark.
+ * @param argc - the number of arguments following '--false-sharing'.
+ * @param argv - the arguments following '--false-sharing'.
+ * @return the process exit code.
+ */
+int run_false_sharing(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "Wrong number of arguments was given, Usage: --false-sharing max_threads increments"
+                  << " [distance ...]" << std::endl;
+        return 1;
+    }
+
+    char *end;
+    long max_threads = strtol(argv[0], &end, 10);
+    if (*end != '\0' || max_threads <= 0) {
+        std::cerr << "Invalid max_threads argument." << std::endl;
+        return 1;
+    }
+    uint64_t increments = strtoull(argv[1], &end, 10);
+    if (*end != '\0' || increments == 0) {
+        std::cerr << "Invalid increments argument." << std::endl;
+        return 1;
+    }
+    std::vector<uint64_t> distances(std::begin(default_distances), std::end(default_distances));
+    if (argc > 2) {
+        distances.clear();
+        for (int i = 2; i < argc; i++) {
+            uint64_t distance = strtoull(argv[i], &end, 10);
+            if (*end != '\0' || distance == 0 || distance % sizeof(uint64_t) != 0) {
+                std::cerr << "Invalid distance argument." << std::endl;
+                return 1;
+            }
+            distances.push_back(distance);
+        }
+    }
+
+    // Every thread needs a core of its own for the layouts to show the cache line ping-pong, so only the cpus the
+    // process may run on are used.
+    std::vector<int> cpus;
+    if (allowed_cpus(cpus) != 0) {
+        std::cerr << "Failed to read the cpu affinity: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    if (max_threads > 1 && cpus.size() < 2) {
+        std::cerr << "At least 2 allowed cpus are needed to run more than one thread." << std::endl;
+        return 1;
+    }
+    if ((size_t) max_threads > cpus.size()) {
+        std::cerr << "Only " << cpus.size() << " cpus are allowed, threads beyond that share cpus." << std::endl;
+    }
+
+    for (uint64_t distance: distances) {
+        for (int threads = 1; threads <= max_threads; threads++) {
+            if (run_layout(distance, threads, increments, cpus) != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+// OS 24 EX1
+
+#ifndef _FALSE_SHARING_H
+#define _FALSE_SHARING_H
+
+#define FALSE_SHARING_SAME_LINE 8
+#define FALSE_SHARING_ADJACENT_LINES 64
+#define FALSE_SHARING_LINE_PAIRS 128
+#define FALSE_SHARING_PAGE_SEPARATED 4096
+
+/**
+ * Runs the false-sharing benchmark: T threads each increment their own counter, with the counters placed at a given
+ * byte distance from each other.
+ * Usage: './memory_latency --false-sharing max_threads increments [distance ...]' where:
+ *      - max_threads - every layout is run with 1, 2, ..., max_threads threads.
+ *      - increments - the number of increments every thread performs.
+ *      - distance - the byte distances between neighbouring counters to check (a multiple of 8). Defaults to the
+ *        same line (8), adjacent lines (64), 128-byte pairs (128) and page-separated (4096) layouts.
+ * Thread i is pinned to the i-th cpu the process may run on (modulo their number), at least 2 cpus are needed for
+ * more than one thread. A thread that can not be pinned fails the run.
+ * The program will print output to stdout in the following format:
+ *      distance,threads,increments_per_second,increments_per_second_per_thread
+ * @param argc - the number of arguments following '--false-sharing'.
+ * @param argv - the arguments following '--false-sharing'.
+ * @return the process exit code.
+ */
+int run_false_sharing(int argc, char *argv[]);
+
+
+#endif
@@ -3,8 +3,6 @@
 #include "memory_latency.h"
 #include "measure.h"
 
-#define GALOIS_POLYNOMIAL ((1ULL << 63) | (1ULL << 62) | (1ULL << 60) | (1ULL << 59))
-
 /**
  * Measures the average latency of accessing a given array.
  * @param repeat - the number of times to repeat the measurement for and average on.
@@ -55,3 +53,111 @@ struct measurement measure_latency(uint64_t repeat, array_element_t* arr, uint64
     result.rnd = rnd;
     return result;
 }
+
+
+/**
+ * Runs a single timed trial of one of the two loops of measure_latency, over elements of type T.
+ * @param repeat - the number of iterations of the loop.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the number of elements of type T in the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param access - true for the memory access loop, false for the baseline loop.
+ * @param rnd - the variable used to randomly access the array, carried between trials to prevent compiler
+ *      optimizations.
+ * @return the average time (ns) taken by a single iteration of the loop.
+ */
+template<typename T>
+double random_width_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                          uint64_t* rnd){
+    const T* elements = reinterpret_cast<const T*>(arr);
+    struct timespec t0;
+    struct timespec t1;
+    uint64_t state=(*rnd & zero) ^ 12345;
+    if (access) {
+        timespec_get(&t0, TIME_UTC);
+        for (uint64_t i = 0; i < repeat; i++)
+        {
+            uint64_t index = state % arr_size;
+            state ^= elements[index] & zero;
+            state = (state >> 1) ^ ((0-(state & 1)) & GALOIS_POLYNOMIAL);  // Advance rnd pseudo-randomly (using Galois LFSR)
+        }
+        timespec_get(&t1, TIME_UTC);
+    } else {
+        timespec_get(&t0, TIME_UTC);
+        for (uint64_t i = 0; i < repeat; i++)
+        {
+            uint64_t index = state % arr_size;
+            state ^= index & zero;
+            state = (state >> 1) ^ ((0-(state & 1)) & GALOIS_POLYNOMIAL);  // Advance rnd pseudo-randomly (using Galois LFSR)
+        }
+        timespec_get(&t1, TIME_UTC);
+    }
+    *rnd = state;
+    return (double)(nanosectime(t1)- nanosectime(t0))/(repeat);
+}
+
+/**
+ * Runs a single timed trial of one of the two loops of measure_sequential_latency, over elements of type T.
+ * @param repeat - the number of iterations of the loop.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the number of elements of type T in the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param access - true for the memory access loop, false for the baseline loop.
+ * @param rnd - the variable used to access the array, carried between trials to prevent compiler optimizations.
+ * @return the average time (ns) taken by a single iteration of the loop.
+ */
+template<typename T>
+double sequential_width_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                              uint64_t* rnd){
+    const T* elements = reinterpret_cast<const T*>(arr);
+    struct timespec t0;
+    struct timespec t1;
+    uint64_t state=(*rnd & zero) ^ 12345;
+    if (access) {
+        timespec_get(&t0, TIME_UTC);
+        for (uint64_t i = 0; i < repeat; i++)
+        {
+            uint64_t index = state % arr_size;
+            state ^= elements[index] & zero;
+            state = -~state;
+        }
+        timespec_get(&t1, TIME_UTC);
+    } else {
+        timespec_get(&t0, TIME_UTC);
+        for (uint64_t i = 0; i < repeat; i++)
+        {
+            uint64_t index = state % arr_size;
+            state ^= index & zero;
+            state = -~state;
+        }
+        timespec_get(&t1, TIME_UTC);
+    }
+    *rnd = state;
+    return (double)(nanosectime(t1)- nanosectime(t0))/(repeat);
+}
+
+template double random_width_trial<uint8_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double random_width_trial<uint16_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double random_width_trial<uint32_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double random_width_trial<uint64_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double sequential_width_trial<uint8_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double sequential_width_trial<uint16_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double sequential_width_trial<uint32_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+template double sequential_width_trial<uint64_t>(uint64_t, array_element_t*, uint64_t, uint64_t, bool, uint64_t*);
+
+
+/**
+ * Runs a single timed trial of one of the two loops of measure_latency.
+ * @param repeat - the number of iterations of the loop.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param access - true for the memory access loop, false for the baseline loop.
+ * @param rnd - the variable used to randomly access the array, carried between trials to prevent compiler
+ *      optimizations.
+ * @return the average time (ns) taken by a single iteration of the loop.
+ */
+double random_latency_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                            uint64_t* rnd){
+    return random_width_trial<array_element_t>(repeat, arr, arr_size, zero, access, rnd);
+}
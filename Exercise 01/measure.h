@@ -19,4 +19,38 @@
  */
 struct measurement measure_latency(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero);
 
+/**
+ * Runs a single timed trial of one of the two loops of measure_latency, over elements of type T.
+ * Instantiated for uint8_t, uint16_t, uint32_t and uint64_t.
+ * @param arr_size - the number of elements of type T in the array arr.
+ * The other parameters and the return value are those of random_latency_trial.
+ */
+template<typename T>
+double random_width_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                          uint64_t* rnd);
+
+/**
+ * Runs a single timed trial of one of the two loops of measure_sequential_latency, over elements of type T.
+ * Instantiated for uint8_t, uint16_t, uint32_t and uint64_t.
+ * @param arr_size - the number of elements of type T in the array arr.
+ * The other parameters and the return value are those of sequential_latency_trial.
+ */
+template<typename T>
+double sequential_width_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                              uint64_t* rnd);
+
+/**
+ * Runs a single timed trial of one of the two loops of measure_latency.
+ * @param repeat - the number of iterations of the loop.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param access - true for the memory access loop, false for the baseline loop.
+ * @param rnd - the variable used to randomly access the array, carried between trials to prevent compiler
+ *      optimizations.
+ * @return the average time (ns) taken by a single iteration of the loop.
+ */
+double random_latency_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                            uint64_t* rnd);
+
 #endif
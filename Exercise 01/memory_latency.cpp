@@ -3,12 +3,15 @@
 #include <cmath>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include "memory_latency.h"
 #include "measure.h"
-
-#define GALOIS_POLYNOMIAL ((1ULL << 63) | (1ULL << 62) | (1ULL << 60) | (1ULL << 59))
-#define STARTING_SIZE 100
+#include "monitor.h"
+#include "alloc_bench.h"
+#include "protocol.h"
+#include "false_sharing.h"
+#include "sweep.h"
 
 /**
  * Converts the struct timespec to time in nano-seconds.
@@ -19,6 +22,16 @@ uint64_t nanosectime(struct timespec t) {
     return t.tv_sec * 1000000000ull + t.tv_nsec;
 }
 
+/**
+ * Advances a size of the geometric series of array sizes iterated by the program.
+ * @param size - the current size.
+ * @param factor - the factor of the geometric series.
+ * @return the next size.
+ */
+uint64_t next_geometric_size(uint64_t size, double factor) {
+    return (uint64_t) ceil((size * factor));
+}
+
 /**
 * Measures the average latency of accessing a given array in a sequential order.
 * @param repeat - the number of times to repeat the measurement for and average on.
@@ -69,25 +82,59 @@ struct measurement measure_sequential_latency(uint64_t repeat, array_element_t *
     return result;
 }
 
+/**
+* Runs a single timed trial of one of the two loops of measure_sequential_latency.
+* @param repeat - the number of iterations of the loop.
+* @param arr - an allocated (not empty) array to preform measurement on.
+* @param arr_size - the length of the array arr.
+* @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+* @param access - true for the memory access loop, false for the baseline loop.
+* @param rnd - the variable used to access the array, carried between trials to prevent compiler optimizations.
+* @return the average time (ns) taken by a single iteration of the loop.
+*/
+double sequential_latency_trial(uint64_t repeat, array_element_t *arr, uint64_t arr_size, uint64_t zero, bool access,
+                                uint64_t *rnd) {
+    return sequential_width_trial<array_element_t>(repeat, arr, arr_size, zero, access, rnd);
+}
+
 
 /**
  * Runs the logic of the memory_latency program. Measures the access latency for random and sequential memory access
  * patterns.
- * Usage: './memory_latency max_size factor repeat' where:
+ * Usage: './memory_latency max_size factor repeat [--stable]' where:
  *      - max_size - the maximum size in bytes of the array to measure access latency for.
  *      - factor - the factor in the geometric series representing the array sizes to check.
  *      - repeat - the number of times each measurement should be repeated for and averaged on.
+ *      - --stable - measure with the drift-resistant protocol (see measure_with_protocol): pinned, warmed up,
+ *        PROTOCOL_DEFAULT_TRIALS interleaved baseline/access trial pairs, context-switched pairs rejected.
  * The program will print output to stdout in the following format:
  *      mem_size_1,offset_1,offset_sequential_1
  *      mem_size_2,offset_2,offset_sequential_2
  *              ...
  *              ...
  *              ...
+ * Alternatively, './memory_latency --monitor ...' runs the memory health monitor daemon (see run_monitor),
+ * './memory_latency --alloc-bench ...' runs the allocator benchmark (see run_alloc_bench),
+ * './memory_latency --false-sharing ...' runs the false-sharing benchmark (see run_false_sharing), and
+ * './memory_latency --sweep ...' runs a matrix of configurations in parallel forked children (see run_sweep).
  */
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
+    if (argc > 1 && strcmp(argv[1], "--monitor") == 0) {
+        return run_monitor(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--alloc-bench") == 0) {
+        return run_alloc_bench(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--false-sharing") == 0) {
+        return run_false_sharing(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "--sweep") == 0) {
+        return run_sweep(argc - 2, argv + 2);
+    }
+    bool stable = argc == 5 && strcmp(argv[4], "--stable") == 0;
+    if (argc != 4 && !stable) {
         std::cerr << "Wrong number of arguments was given, " << argv[0]
-                  << " Usage: max_size factor repeat" << std::endl;
+                  << " Usage: max_size factor repeat [--stable]" << std::endl;
         return 1;
     }
 
@@ -119,6 +166,10 @@ int main(int argc, char *argv[]) {
     timespec_get(&t_dummy, TIME_UTC);
     const uint64_t zero = nanosectime(t_dummy) > 1000000000ull ? 0 : nanosectime(t_dummy);
 
+    if (stable) {
+        protocol_prepare();
+    }
+
     uint64_t size = STARTING_SIZE;
     while (size <= max_size) {
         array_element_t *arr = (array_element_t *) malloc(size);
@@ -130,15 +181,33 @@ int main(int argc, char *argv[]) {
             arr[i] = i;
         }
 
-        struct measurement random_latency = measure_latency(repeat, arr, size / sizeof(array_element_t), zero);
-        struct measurement sequential_latency = measure_sequential_latency(repeat, arr, size/ sizeof(array_element_t), zero);
+        struct measurement random_latency;
+        struct measurement sequential_latency;
+        if (stable) {
+            struct protocol_report random_report;
+            struct protocol_report sequential_report;
+            random_latency = measure_with_protocol(random_latency_trial, repeat, arr, size / sizeof(array_element_t),
+                                                   zero, PROTOCOL_DEFAULT_TRIALS, &random_report);
+            sequential_latency = measure_with_protocol(sequential_latency_trial, repeat, arr,
+                                                       size / sizeof(array_element_t), zero, PROTOCOL_DEFAULT_TRIALS,
+                                                       &sequential_report);
+            if (random_report.accepted < PROTOCOL_DEFAULT_TRIALS ||
+                sequential_report.accepted < PROTOCOL_DEFAULT_TRIALS) {
+                std::cerr << "Warning: too many disturbed trials at size " << size << ", accepted "
+                          << random_report.accepted << " random and " << sequential_report.accepted
+                          << " sequential pairs out of " << PROTOCOL_DEFAULT_TRIALS << "." << std::endl;
+            }
+        } else {
+            random_latency = measure_latency(repeat, arr, size / sizeof(array_element_t), zero);
+            sequential_latency = measure_sequential_latency(repeat, arr, size / sizeof(array_element_t), zero);
+        }
 
         std::cout << size << ","
                   << random_latency.access_time - random_latency.baseline << ","
                   << sequential_latency.access_time - sequential_latency.baseline << "\n";
 
         free(arr);
-        size = (uint64_t) ceil((size * factor));
+        size = next_geometric_size(size, factor);
     }
     return 0;
 }
\ No newline at end of file
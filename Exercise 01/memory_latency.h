@@ -10,6 +10,11 @@
 
 typedef uint64_t array_element_t;
 
+#define STARTING_SIZE 100
+
+// Feedback polynomial of the Galois LFSR used to pseudo-randomly advance rnd.
+#define GALOIS_POLYNOMIAL ((1ULL << 63) | (1ULL << 62) | (1ULL << 60) | (1ULL << 59))
+
 
 /**
  * Used as the return type for 'measure_latency'.
@@ -29,6 +34,15 @@ struct measurement {
 uint64_t nanosectime(struct timespec t);
 
 
+/**
+ * Advances a size of the geometric series of array sizes iterated by the program.
+ * @param size - the current size.
+ * @param factor - the factor of the geometric series.
+ * @return the next size.
+ */
+uint64_t next_geometric_size(uint64_t size, double factor);
+
+
 /**
 * Measures the average latency of accessing a given array in a sequential order.
 * @param repeat - the number of times to repeat the measurement for and average on.
@@ -43,4 +57,18 @@ uint64_t nanosectime(struct timespec t);
 struct measurement measure_sequential_latency(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero);
 
 
+/**
+* Runs a single timed trial of one of the two loops of measure_sequential_latency.
+* @param repeat - the number of iterations of the loop.
+* @param arr - an allocated (not empty) array to preform measurement on.
+* @param arr_size - the length of the array arr.
+* @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+* @param access - true for the memory access loop, false for the baseline loop.
+* @param rnd - the variable used to access the array, carried between trials to prevent compiler optimizations.
+* @return the average time (ns) taken by a single iteration of the loop.
+*/
+double sequential_latency_trial(uint64_t repeat, array_element_t* arr, uint64_t arr_size, uint64_t zero, bool access,
+                                uint64_t* rnd);
+
+
 #endif
@@ -0,0 +1,349 @@
+// OS 24 EX1
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "memory_latency.h"
+#include "measure.h"
+#include "cpu_affinity.h"
+#include "monitor.h"
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+#define MILLISECONDS_PER_SECOND 1000
+
+static const double reported_quantiles[] = {0.5, 0.9, 0.99};
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/**
+ * Asks the monitor loop to stop after the current probe.
+ * @param sig - the signal received.
+ */
+static void request_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+}
+
+/**
+ * Adds a sample to a rolling window, replacing the oldest one once the window is full.
+ * @param window - the window to add to (its samples vector must be sized to the window length).
+ * @param sample - the sample to add.
+ */
+void rolling_window_add(struct rolling_window &window, double sample) {
+    window.samples[window.next % window.samples.size()] = sample;
+    window.next++;
+    window.count++;
+    window.sum += sample;
+}
+
+/**
+ * Computes a percentile over the samples currently kept in a rolling window.
+ * @param window - the window.
+ * @param quantile - the quantile to compute, in [0, 1].
+ * @return the percentile, or 0 if the window is empty.
+ */
+double rolling_window_percentile(const struct rolling_window &window, double quantile) {
+    uint64_t kept = std::min<uint64_t>(window.count, window.samples.size());
+    if (kept == 0) {
+        return 0;
+    }
+    std::vector<double> sorted(window.samples.begin(), window.samples.begin() + kept);
+    uint64_t rank = (uint64_t) (quantile * (double) (kept - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+/**
+ * Measures the sequential read bandwidth of a given array.
+ * @param arr - an allocated (not empty) array to read.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param sink - receives a value depending on every element read, to prevent compiler optimizations.
+ * @return the read bandwidth in bytes per second.
+ */
+double measure_read_bandwidth(const uint64_t *arr, uint64_t arr_size, uint64_t zero, uint64_t *sink) {
+    struct timespec t0;
+    timespec_get(&t0, TIME_UTC);
+    // Four independent sums keep several loads in flight, so the loop is bound by memory and not by the adds.
+    uint64_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    uint64_t i = 0;
+    for (; i + 4 <= arr_size; i += 4) {
+        sum0 += arr[i];
+        sum1 += arr[i + 1];
+        sum2 += arr[i + 2];
+        sum3 += arr[i + 3];
+    }
+    for (; i < arr_size; i++) {
+        sum0 += arr[i];
+    }
+    struct timespec t1;
+    timespec_get(&t1, TIME_UTC);
+
+    *sink ^= (sum0 + sum1 + sum2 + sum3) & zero;
+    uint64_t elapsed = nanosectime(t1) - nanosectime(t0);
+    return (double) (arr_size * sizeof(uint64_t)) * NANOSECONDS_PER_SECOND / (double) (elapsed ? elapsed : 1);
+}
+
+/**
+ * Appends a Prometheus summary built from a rolling window to the exposition text.
+ * @param out - the exposition text.
+ * @param name - the metric name.
+ * @param help - the metric description.
+ * @param window - the window holding the samples.
+ */
+static void write_summary(std::ostringstream &out, const char *name, const char *help,
+                          const struct rolling_window &window) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " summary\n";
+    for (double quantile: reported_quantiles) {
+        out << name << "{quantile=\"" << quantile << "\"} " << rolling_window_percentile(window, quantile) << "\n";
+    }
+    out << name << "_sum " << window.sum << "\n";
+    out << name << "_count " << window.count << "\n";
+}
+
+/**
+ * Writes the exposition text to a file, through a rename so readers never see a partially written file.
+ * @param path - the file to write.
+ * @param text - the exposition text.
+ * @return 0 on success, -1 on failure.
+ */
+static int write_metrics_file(const std::string &path, const std::string &text) {
+    std::string tmp_path = path + ".tmp";
+    FILE *file = fopen(tmp_path.c_str(), "w");
+    if (file == nullptr) {
+        return -1;
+    }
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (fclose(file) != 0 || !written) {
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return rename(tmp_path.c_str(), path.c_str());
+}
+
+/**
+ * Removes a stale Unix-domain socket. Anything else at the path is left alone, so a mistyped path can not delete
+ * a regular file.
+ * @param path - the socket path.
+ * @return 0 if nothing is left at the path, -1 on failure (errno is EEXIST when the path is not a socket).
+ */
+static int unlink_metrics_socket(const std::string &path) {
+    struct stat st{};
+    if (lstat(path.c_str(), &st) < 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        errno = EEXIST;
+        return -1;
+    }
+    return unlink(path.c_str());
+}
+
+/**
+ * Opens a listening Unix-domain socket.
+ * @param path - the socket path, replaced if it is a socket already. Fails if anything else is there.
+ * @return the listening socket, or -1 on failure.
+ */
+static int open_metrics_socket(const std::string &path) {
+    struct sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (unlink_metrics_socket(path) < 0) {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Sends the exposition text to every client waiting on the listening socket.
+ * The clients are nonblocking, a client whose socket buffer can't take the whole text is dropped rather than
+ * stalling the probes.
+ * @param listen_fd - the listening socket.
+ * @param text - the exposition text.
+ */
+static void serve_metrics_clients(int listen_fd, const std::string &text) {
+    int client;
+    while ((client = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        size_t sent = 0;
+        while (sent < text.size()) {
+            ssize_t n = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        close(client);
+    }
+}
+
+/**
+ * Runs memory_latency as a memory health monitor daemon.
+ * @param argc - the number of arguments following '--monitor'.
+ * @param argv - the arguments following '--monitor'.
+ * @return the process exit code.
+ */
+int run_monitor(int argc, char *argv[]) {
+    if (argc != 4 && argc != 5) {
+        std::cerr << "Wrong number of arguments was given, Usage: --monitor buffer_size interval_ms repeat output"
+                  << " [window]" << std::endl;
+        return 1;
+    }
+
+    char *end;
+    uint64_t buffer_size = strtoull(argv[0], &end, 10);
+    if (*end != '\0' || buffer_size < sizeof(array_element_t)) {
+        std::cerr << "Invalid buffer_size argument." << std::endl;
+        return 1;
+    }
+    uint64_t interval_ms = strtoull(argv[1], &end, 10);
+    if (*end != '\0' || interval_ms == 0) {
+        std::cerr << "Invalid interval_ms argument." << std::endl;
+        return 1;
+    }
+    uint64_t repeat = strtoull(argv[2], &end, 10);
+    if (*end != '\0' || repeat == 0) {
+        std::cerr << "Invalid repeat argument." << std::endl;
+        return 1;
+    }
+    uint64_t window_length = MONITOR_DEFAULT_WINDOW;
+    if (argc == 5) {
+        window_length = strtoull(argv[4], &end, 10);
+        if (*end != '\0' || window_length == 0) {
+            std::cerr << "Invalid window argument." << std::endl;
+            return 1;
+        }
+    }
+
+    std::string output = argv[3];
+    bool use_socket = output.compare(0, strlen(MONITOR_UNIX_SOCKET_PREFIX), MONITOR_UNIX_SOCKET_PREFIX) == 0;
+    int listen_fd = -1;
+    if (use_socket) {
+        output = output.substr(strlen(MONITOR_UNIX_SOCKET_PREFIX));
+        listen_fd = open_metrics_socket(output);
+        if (listen_fd < 0) {
+            std::cerr << "Failed to listen on " << output << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+    }
+
+    uint64_t arr_size = buffer_size / sizeof(array_element_t);
+    array_element_t *arr = (array_element_t *) malloc(arr_size * sizeof(array_element_t));
+    if (arr == nullptr) {
+        std::cerr << "Malloc Failed" << std::endl;
+        return 1;
+    }
+    for (uint64_t i = 0; i < arr_size; i++) {
+        arr[i] = i;
+    }
+
+    struct sigaction sa{};
+    sa.sa_handler = &request_stop;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    struct timespec t_dummy{};
+    timespec_get(&t_dummy, TIME_UTC);
+    const uint64_t zero = nanosectime(t_dummy) > 1000000000ull ? 0 : nanosectime(t_dummy);
+
+    struct rolling_window latency = {std::vector<double>(window_length), 0, 0, 0};
+    struct rolling_window bandwidth = {std::vector<double>(window_length), 0, 0, 0};
+    // The cpus the probes may move between, read once since every probe narrows the mask down to a single cpu.
+    std::vector<int> cpus;
+    if (allowed_cpus(cpus) != 0 || cpus.empty()) {
+        std::cerr << "Failed to read the cpu affinity: " << strerror(errno) << std::endl;
+        free(arr);
+        return 1;
+    }
+    std::vector<struct cpu_times> previous_times, current_times;
+    read_cpu_times(previous_times);
+    uint64_t sink = 0;
+    std::string text;
+
+    while (!stop_requested) {
+        struct timespec probe_start;
+        timespec_get(&probe_start, TIME_UTC);
+
+        // Probe on the cpu that had the most idle time since the last probe, to disturb the host as little
+        // as possible and to keep our own measurement away from busy cores.
+        int cpu = cpus[0];
+        if (read_cpu_times(current_times) == 0) {
+            cpu = find_idlest_cpu(previous_times, current_times, cpus);
+            previous_times.swap(current_times);
+        }
+        if (pin_thread_to_cpu(cpu) != 0) { // The cpu went offline, or the mask was narrowed since.
+            std::cerr << "Failed to pin the probe to cpu " << cpu << ": " << strerror(errno) << std::endl;
+            cpu = sched_getcpu();
+        }
+
+        struct measurement probe = measure_latency(repeat, arr, arr_size, zero);
+        sink ^= probe.rnd & zero;
+        rolling_window_add(latency, (probe.access_time - probe.baseline) / NANOSECONDS_PER_SECOND);
+        rolling_window_add(bandwidth, measure_read_bandwidth(arr, arr_size, zero, &sink));
+
+        std::ostringstream out;
+        write_summary(out, "memory_monitor_random_access_latency_seconds",
+                      "Latency of a random access to the probe buffer, baseline subtracted.", latency);
+        write_summary(out, "memory_monitor_read_bandwidth_bytes_per_second",
+                      "Sequential read bandwidth over the probe buffer.", bandwidth);
+        out << "# HELP memory_monitor_probe_buffer_bytes Size of the probe buffer.\n"
+            << "# TYPE memory_monitor_probe_buffer_bytes gauge\n"
+            << "memory_monitor_probe_buffer_bytes " << arr_size * sizeof(array_element_t) << "\n"
+            << "# HELP memory_monitor_probe_cpu The cpu the last probe ran on.\n"
+            << "# TYPE memory_monitor_probe_cpu gauge\n"
+            << "memory_monitor_probe_cpu " << cpu << "\n";
+        text = out.str();
+
+        if (!use_socket && write_metrics_file(output, text) != 0) {
+            std::cerr << "Failed to write " << output << ": " << strerror(errno) << std::endl;
+        }
+
+        // Wait for the next probe, answering socket clients in the meantime.
+        struct timespec now;
+        timespec_get(&now, TIME_UTC);
+        uint64_t deadline = nanosectime(probe_start) + interval_ms * (NANOSECONDS_PER_SECOND / MILLISECONDS_PER_SECOND);
+        while (!stop_requested && nanosectime(now) < deadline) {
+            int timeout_ms = (int) ((deadline - nanosectime(now)) / (NANOSECONDS_PER_SECOND / MILLISECONDS_PER_SECOND)) + 1;
+            struct pollfd pfd = {listen_fd, POLLIN, 0};
+            if (poll(&pfd, use_socket ? 1 : 0, timeout_ms) > 0) {
+                serve_metrics_clients(listen_fd, text);
+            }
+            timespec_get(&now, TIME_UTC);
+        }
+    }
+
+    if (use_socket) {
+        close(listen_fd);
+        unlink_metrics_socket(output);
+    }
+    free(arr);
+    return sink == 1 ? 1 : 0; // sink is always 0, returning through it keeps the probes from being optimized out.
+}
@@ -0,0 +1,70 @@
+// OS 24 EX1
+
+#ifndef _MONITOR_H
+#define _MONITOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#define MONITOR_DEFAULT_WINDOW 120
+#define MONITOR_UNIX_SOCKET_PREFIX "unix:"
+
+/**
+ * Keeps the last samples of a probe for percentiles, along with the all-time sum and count.
+ */
+struct rolling_window {
+    std::vector<double> samples;
+    uint64_t next;
+    uint64_t count;
+    double sum;
+};
+
+
+/**
+ * Adds a sample to a rolling window, replacing the oldest one once the window is full.
+ * @param window - the window to add to (its samples vector must be sized to the window length).
+ * @param sample - the sample to add.
+ */
+void rolling_window_add(struct rolling_window &window, double sample);
+
+
+/**
+ * Computes a percentile over the samples currently kept in a rolling window.
+ * @param window - the window.
+ * @param quantile - the quantile to compute, in [0, 1].
+ * @return the percentile, or 0 if the window is empty.
+ */
+double rolling_window_percentile(const struct rolling_window &window, double quantile);
+
+
+/**
+ * Measures the sequential read bandwidth of a given array.
+ * @param arr - an allocated (not empty) array to read.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param sink - receives a value depending on every element read, to prevent compiler optimizations.
+ * @return the read bandwidth in bytes per second.
+ */
+double measure_read_bandwidth(const uint64_t *arr, uint64_t arr_size, uint64_t zero, uint64_t *sink);
+
+
+/**
+ * Runs memory_latency as a memory health monitor daemon.
+ * Usage: './memory_latency --monitor buffer_size interval_ms repeat output [window]' where:
+ *      - buffer_size - the size in bytes of the array the probes run on.
+ *      - interval_ms - the time between two probes in milliseconds.
+ *      - repeat - the number of accesses of each latency probe.
+ *      - output - a file to rewrite in the Prometheus text format after every probe, or 'unix:<path>' for a
+ *        Unix-domain socket that serves the same text to every connecting client. A stale socket at the path is
+ *        replaced, anything else there is an error.
+ *      - window - the number of recent probes the percentiles are computed over.
+ * Every probe pins itself to the cpu that was the most idle since the previous probe, among the cpus the daemon was
+ * allowed to run on when it started. The daemon runs until it receives SIGINT or SIGTERM.
+ * @param argc - the number of arguments following '--monitor'.
+ * @param argv - the arguments following '--monitor'.
+ * @return the process exit code.
+ */
+int run_monitor(int argc, char *argv[]);
+
+
+#endif
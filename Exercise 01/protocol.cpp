@@ -0,0 +1,150 @@
+// OS 24 EX1
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <sys/resource.h>
+#include "cpu_affinity.h"
+#include "protocol.h"
+
+#define GOVERNOR_PATH_PREFIX "/sys/devices/system/cpu/cpu"
+#define GOVERNOR_PATH_SUFFIX "/cpufreq/scaling_governor"
+#define INTEL_NO_TURBO_PATH "/sys/devices/system/cpu/intel_pstate/no_turbo"
+#define CPUFREQ_BOOST_PATH "/sys/devices/system/cpu/cpufreq/boost"
+
+/**
+ * Reads the first word of a sysfs file.
+ * @param path - the file.
+ * @param value - receives the word.
+ * @return true if the file could be read.
+ */
+static bool read_sysfs_word(const std::string &path, std::string &value) {
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+
+/**
+ * Counts the context switches of the calling thread so far.
+ * @return the number of voluntary and involuntary context switches.
+ */
+static long context_switches() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+/**
+ * Computes the median of a set of samples.
+ * @param samples - the samples (reordered).
+ * @return the median, or 0 if there are no samples.
+ */
+static double median(std::vector<double> &samples) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+/**
+ * Prepares the calling thread for stable measurements: pins it to the cpu it currently runs on, and warns on stderr
+ * if the cpu frequency governor is not 'performance' or if turbo is enabled.
+ * @return the cpu the thread was pinned to, or -1 if pinning failed.
+ */
+int protocol_prepare() {
+    int cpu = sched_getcpu();
+    if (cpu < 0 || pin_thread_to_cpu(cpu) != 0) {
+        std::cerr << "Warning: failed to pin the measuring thread to a cpu." << std::endl;
+        return -1;
+    }
+    protocol_check_frequency(cpu);
+    return cpu;
+}
+
+/**
+ * Warns on stderr if the frequency governor of a cpu is not 'performance' or if turbo is enabled.
+ * @param cpu - the cpu to check.
+ */
+void protocol_check_frequency(int cpu) {
+    std::string value;
+    if (read_sysfs_word(GOVERNOR_PATH_PREFIX + std::to_string(cpu) + GOVERNOR_PATH_SUFFIX, value) &&
+        value != "performance") {
+        std::cerr << "Warning: cpu" << cpu << " uses the '" << value << "' frequency governor, results may drift."
+                  << " Consider the 'performance' governor." << std::endl;
+    }
+    if ((read_sysfs_word(INTEL_NO_TURBO_PATH, value) && value == "0") ||
+        (read_sysfs_word(CPUFREQ_BOOST_PATH, value) && value == "1")) {
+        std::cerr << "Warning: turbo is enabled, results may drift with the temperature and the load of other cores."
+                  << std::endl;
+    }
+}
+
+/**
+ * Measures the average latency of accessing a given array with the drift-resistant protocol.
+ * @param trial - the measurement loop to run.
+ * @param repeat - the number of iterations of every trial.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param trials - the number of AB pairs to accept.
+ * @param report - if not null, receives the number of warmup, accepted and rejected trials.
+ * @return struct measurement where baseline is the median baseline trial, and access_time is the baseline plus the
+ *      median of the per-pair access - baseline differences.
+ */
+struct measurement measure_with_protocol(latency_trial_t trial, uint64_t repeat, array_element_t *arr,
+                                         uint64_t arr_size, uint64_t zero, uint64_t trials,
+                                         struct protocol_report *report) {
+    repeat = arr_size > repeat ? arr_size : repeat; // Make sure repeat >= arr_size
+    uint64_t rnd = 12345;
+    struct protocol_report counts = {0, 0, 0};
+
+    // Warmup: wait for the baseline to settle, then bring the array into whatever cache level it fits in.
+    double previous = trial(repeat, arr, arr_size, zero, false, &rnd);
+    for (counts.warmup_trials = 1; counts.warmup_trials < PROTOCOL_WARMUP_MAX_TRIALS; counts.warmup_trials++) {
+        double current = trial(repeat, arr, arr_size, zero, false, &rnd);
+        bool settled = fabs(current - previous) <= PROTOCOL_WARMUP_TOLERANCE * previous;
+        previous = current;
+        if (settled) {
+            break;
+        }
+    }
+    trial(repeat, arr, arr_size, zero, true, &rnd);
+
+    std::vector<double> baselines;
+    std::vector<double> differences;
+    uint64_t max_rejects = trials * PROTOCOL_MAX_REJECTS_PER_TRIAL;
+    while (counts.accepted < trials && counts.rejected <= max_rejects) {
+        long switches_before = context_switches();
+        double baseline = trial(repeat, arr, arr_size, zero, false, &rnd);
+        double access = trial(repeat, arr, arr_size, zero, true, &rnd);
+        if (context_switches() != switches_before) {
+            counts.rejected++;
+            continue;
+        }
+        baselines.push_back(baseline);
+        differences.push_back(access - baseline);
+        counts.accepted++;
+    }
+    if (counts.accepted == 0) {
+        // Every pair was disturbed; fall back to a single undisturbed-or-not pair rather than reporting nothing.
+        baselines.push_back(trial(repeat, arr, arr_size, zero, false, &rnd));
+        differences.push_back(trial(repeat, arr, arr_size, zero, true, &rnd) - baselines.back());
+    }
+
+    if (report != nullptr) {
+        *report = counts;
+    }
+    struct measurement result;
+    result.baseline = median(baselines);
+    result.access_time = result.baseline + median(differences);
+    result.rnd = rnd;
+    return result;
+}
@@ -0,0 +1,65 @@
+// OS 24 EX1
+
+#ifndef _PROTOCOL_H
+#define _PROTOCOL_H
+
+#include "memory_latency.h"
+
+#define PROTOCOL_DEFAULT_TRIALS 16
+#define PROTOCOL_MAX_REJECTS_PER_TRIAL 4
+#define PROTOCOL_WARMUP_TOLERANCE 0.02
+#define PROTOCOL_WARMUP_MAX_TRIALS 64
+
+/**
+ * A single timed trial of a measurement loop, see random_latency_trial and sequential_latency_trial.
+ */
+typedef double (*latency_trial_t)(uint64_t repeat, array_element_t *arr, uint64_t arr_size, uint64_t zero,
+                                  bool access, uint64_t *rnd);
+
+/**
+ * Counts what the protocol did, for reporting.
+ */
+struct protocol_report {
+    uint64_t warmup_trials;
+    uint64_t accepted;
+    uint64_t rejected;
+};
+
+
+/**
+ * Warns on stderr if the frequency governor of a cpu is not 'performance' or if turbo is enabled.
+ * @param cpu - the cpu to check.
+ */
+void protocol_check_frequency(int cpu);
+
+
+/**
+ * Prepares the calling thread for stable measurements: pins it to the cpu it currently runs on, and warns on stderr
+ * if the cpu frequency governor is not 'performance' or if turbo is enabled.
+ * @return the cpu the thread was pinned to, or -1 if pinning failed.
+ */
+int protocol_prepare();
+
+
+/**
+ * Measures the average latency of accessing a given array with the drift-resistant protocol:
+ *      - a warmup that repeats baseline trials until two consecutive ones agree within PROTOCOL_WARMUP_TOLERANCE,
+ *        so the core has reached its steady frequency (and a single access trial to warm the caches);
+ *      - baseline (A) and access (B) trials interleaved ABAB, so a slow frequency drift affects both alike;
+ *      - pairs during which the thread was context switched (seen through getrusage) are rejected and retried.
+ * @param trial - the measurement loop to run.
+ * @param repeat - the number of iterations of every trial.
+ * @param arr - an allocated (not empty) array to preform measurement on.
+ * @param arr_size - the length of the array arr.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param trials - the number of AB pairs to accept.
+ * @param report - if not null, receives the number of warmup, accepted and rejected trials.
+ * @return struct measurement where baseline is the median baseline trial, and access_time is the baseline plus the
+ *      median of the per-pair access - baseline differences.
+ */
+struct measurement measure_with_protocol(latency_trial_t trial, uint64_t repeat, array_element_t *arr,
+                                         uint64_t arr_size, uint64_t zero, uint64_t trials,
+                                         struct protocol_report *report);
+
+
+#endif
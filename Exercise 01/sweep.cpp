@@ -0,0 +1,362 @@
+// OS 24 EX1
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "memory_latency.h"
+#include "measure.h"
+#include "cpu_affinity.h"
+#include "protocol.h"
+#include "sweep.h"
+
+/**
+ * What a sweep child reports back to the parent through its pipe.
+ */
+struct sweep_result {
+    double latency;
+    int ok;
+};
+
+/**
+ * A configuration currently running in a child.
+ */
+struct sweep_child {
+    size_t config;
+    int socket;
+    int fd;
+};
+
+/**
+ * Selects the trial of a pattern and element width.
+ * @param pattern - random or sequential.
+ * @param width - the element width in bytes.
+ * @return the trial.
+ */
+static latency_trial_t select_trial(const std::string &pattern, int width) {
+    bool random = pattern == "random";
+    switch (width) {
+        case 1:
+            return random ? random_width_trial<uint8_t> : sequential_width_trial<uint8_t>;
+        case 2:
+            return random ? random_width_trial<uint16_t> : sequential_width_trial<uint16_t>;
+        case 4:
+            return random ? random_width_trial<uint32_t> : sequential_width_trial<uint32_t>;
+        default:
+            return random ? random_width_trial<uint64_t> : sequential_width_trial<uint64_t>;
+    }
+}
+
+/**
+ * Allocates the measured array with the configured backing.
+ * @param backing - malloc, mmap or thp.
+ * @param size - the size in bytes.
+ * @return the array, or nullptr on failure.
+ */
+static void *allocate_backing(const std::string &backing, uint64_t size) {
+    if (backing == "malloc") {
+        return malloc(size);
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    if (backing == "thp") {
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+    return ptr;
+}
+
+/**
+ * Releases an array returned by allocate_backing.
+ * @param backing - the backing it was allocated with.
+ * @param ptr - the array.
+ * @param size - the size in bytes.
+ */
+static void release_backing(const std::string &backing, void *ptr, uint64_t size) {
+    if (backing == "malloc") {
+        free(ptr);
+    } else {
+        munmap(ptr, size);
+    }
+}
+
+/**
+ * Measures a configuration on a single thread of the child.
+ * @param config - the configuration.
+ * @param cpu - the cpu to pin the thread to.
+ * @param zero - a variable containing zero in a way that the compiler doesn't "know" it in compilation time.
+ * @param result - receives the latency offset of this thread.
+ */
+static void measure_config_thread(const struct sweep_config *config, int cpu, uint64_t zero,
+                                  struct sweep_result *result) {
+    pin_thread_to_cpu(cpu);
+    // Allocated and initialized after pinning, so first touch places the array on the configured node.
+    void *arr = allocate_backing(config->backing, config->size);
+    if (arr == nullptr) {
+        result->ok = 0;
+        return;
+    }
+    uint64_t arr_size = config->size / config->width;
+    for (uint64_t i = 0; i < arr_size; i++) {
+        switch (config->width) {
+            case 1:
+                static_cast<uint8_t *>(arr)[i] = (uint8_t) i;
+                break;
+            case 2:
+                static_cast<uint16_t *>(arr)[i] = (uint16_t) i;
+                break;
+            case 4:
+                static_cast<uint32_t *>(arr)[i] = (uint32_t) i;
+                break;
+            default:
+                static_cast<uint64_t *>(arr)[i] = i;
+        }
+    }
+
+    struct measurement latency = measure_with_protocol(select_trial(config->pattern, config->width), config->repeat,
+                                                       static_cast<array_element_t *>(arr), arr_size, zero,
+                                                       PROTOCOL_DEFAULT_TRIALS, nullptr);
+    result->latency = latency.access_time - latency.baseline;
+    result->ok = 1;
+    release_backing(config->backing, arr, config->size);
+}
+
+/**
+ * The body of a sweep child: measures a configuration on every configured thread and writes the average offset to
+ * the pipe.
+ * @param config - the configuration.
+ * @param cpus - the cpus of the configured node.
+ * @param fd - the write end of the pipe to the parent.
+ */
+static void run_config_child(const struct sweep_config &config, const std::vector<int> &cpus, int fd) {
+    pin_thread_to_cpus(cpus);
+
+    struct timespec t_dummy{};
+    timespec_get(&t_dummy, TIME_UTC);
+    const uint64_t zero = nanosectime(t_dummy) > 1000000000ull ? 0 : nanosectime(t_dummy);
+
+    std::vector<struct sweep_result> results(config.threads, sweep_result{0, 0});
+    std::vector<std::thread> pool;
+    for (int i = 0; i < config.threads; i++) {
+        pool.emplace_back(measure_config_thread, &config, cpus[i % cpus.size()], zero, &results[i]);
+    }
+    struct sweep_result result = {0, 1};
+    for (int i = 0; i < config.threads; i++) {
+        pool[i].join();
+        result.latency += results[i].latency / config.threads;
+        result.ok &= results[i].ok;
+    }
+    if (write(fd, &result, sizeof(result)) != sizeof(result)) {
+        _exit(1);
+    }
+}
+
+/**
+ * Splits a comma separated list.
+ * @param list - the list.
+ * @return the values.
+ */
+static std::vector<std::string> split_values(const std::string &list) {
+    std::vector<std::string> values;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        values.push_back(list.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return values;
+}
+
+/**
+ * Parses an unsigned integer matrix value.
+ * @param value - the value.
+ * @param result - receives the parsed integer.
+ * @return true if the value is an unsigned integer.
+ */
+static bool parse_unsigned(const std::string &value, uint64_t &result) {
+    char *end;
+    result = strtoull(value.c_str(), &end, 10);
+    return !value.empty() && value[0] != '-' && *end == '\0';
+}
+
+/**
+ * Parses the sweep matrix from 'key=value,value,...' arguments and expands it into its cartesian product.
+ * Keys that are not given take a single default value.
+ * @param argc - the number of matrix arguments.
+ * @param argv - the matrix arguments.
+ * @param configs - receives the configurations.
+ * @return 0 on success, -1 on an invalid argument.
+ */
+int parse_sweep_matrix(int argc, char *argv[], std::vector<struct sweep_config> &configs) {
+    std::map<std::string, std::vector<std::string>> matrix = {
+            {"backing", {"malloc"}}, {"pattern", {"random"}}, {"width", {"8"}}, {"threads", {"1"}},
+            {"node", {"0"}}, {"size", {"1048576"}}, {"repeat", {"1000000"}}};
+    for (int i = 0; i < argc; i++) {
+        std::string argument = argv[i];
+        size_t equals = argument.find('=');
+        if (equals == std::string::npos || matrix.count(argument.substr(0, equals)) == 0) {
+            std::cerr << "Invalid matrix argument: " << argument << std::endl;
+            return -1;
+        }
+        matrix[argument.substr(0, equals)] = split_values(argument.substr(equals + 1));
+    }
+
+    configs.clear();
+    uint64_t width, threads, node, size, repeat;
+    for (const std::string &backing: matrix["backing"]) {
+        if (backing != "malloc" && backing != "mmap" && backing != "thp") {
+            std::cerr << "Invalid backing: " << backing << std::endl;
+            return -1;
+        }
+        for (const std::string &pattern: matrix["pattern"]) {
+            if (pattern != "random" && pattern != "sequential") {
+                std::cerr << "Invalid pattern: " << pattern << std::endl;
+                return -1;
+            }
+            for (const std::string &width_value: matrix["width"]) {
+                if (!parse_unsigned(width_value, width) || (width != 1 && width != 2 && width != 4 && width != 8)) {
+                    std::cerr << "Invalid width: " << width_value << std::endl;
+                    return -1;
+                }
+                for (const std::string &threads_value: matrix["threads"]) {
+                    if (!parse_unsigned(threads_value, threads) || threads == 0) {
+                        std::cerr << "Invalid threads: " << threads_value << std::endl;
+                        return -1;
+                    }
+                    for (const std::string &node_value: matrix["node"]) {
+                        if (!parse_unsigned(node_value, node)) {
+                            std::cerr << "Invalid node: " << node_value << std::endl;
+                            return -1;
+                        }
+                        for (const std::string &size_value: matrix["size"]) {
+                            if (!parse_unsigned(size_value, size) || size < width) {
+                                std::cerr << "Invalid size: " << size_value << std::endl;
+                                return -1;
+                            }
+                            for (const std::string &repeat_value: matrix["repeat"]) {
+                                if (!parse_unsigned(repeat_value, repeat) || repeat == 0) {
+                                    std::cerr << "Invalid repeat: " << repeat_value << std::endl;
+                                    return -1;
+                                }
+                                configs.push_back(sweep_config{backing, pattern, (int) width, (int) threads,
+                                                               (int) node, size, repeat});
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs a matrix of configurations, each in a forked child pinned to the cpus of its NUMA node.
+ * @param argc - the number of arguments following '--sweep'.
+ * @param argv - the arguments following '--sweep'.
+ * @return the process exit code.
+ */
+int run_sweep(int argc, char *argv[]) {
+    if (argc < 1) {
+        std::cerr << "Wrong number of arguments was given, Usage: --sweep results_file [key=value,value,... ...]"
+                  << std::endl;
+        return 1;
+    }
+    std::vector<struct sweep_config> configs;
+    if (parse_sweep_matrix(argc - 1, argv + 1, configs) != 0) {
+        return 1;
+    }
+    std::vector<std::vector<int>> nodes;
+    read_numa_nodes(nodes);
+    for (const struct sweep_config &config: configs) {
+        if ((size_t) config.node >= nodes.size() || nodes[config.node].empty()) {
+            std::cerr << "Invalid node: " << config.node << " has no cpus." << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream results(argv[0]);
+    if (!results) {
+        std::cerr << "Failed to open " << argv[0] << std::endl;
+        return 1;
+    }
+    results << "backing,pattern,width,threads,node,size,repeat,latency_ns,status\n";
+    std::map<int, bool> checked_nodes;
+    for (const struct sweep_config &config: configs) {
+        if (!checked_nodes[config.node]) {
+            checked_nodes[config.node] = true;
+            protocol_check_frequency(nodes[config.node].front());
+        }
+    }
+
+    std::vector<bool> started(configs.size(), false);
+    size_t pending = configs.size();
+    std::map<int, pid_t> busy_sockets;
+    std::map<pid_t, struct sweep_child> children;
+    int failures = 0;
+    while (pending > 0 || !children.empty()) {
+        // Start the first pending configuration of every idle socket, in matrix order.
+        for (size_t next = 0; next < configs.size() && pending > 0; next++) {
+            const struct sweep_config &config = configs[next];
+            int socket = cpu_socket(nodes[config.node].front());
+            if (started[next] || busy_sockets.count(socket) != 0) {
+                continue;
+            }
+            int fds[2];
+            if (pipe(fds) != 0) {
+                std::cerr << "pipe failed: " << strerror(errno) << std::endl;
+                return 1;
+            }
+            std::cout.flush();
+            pid_t pid = fork();
+            if (pid < 0) {
+                std::cerr << "fork failed: " << strerror(errno) << std::endl;
+                return 1;
+            }
+            if (pid == 0) {
+                close(fds[0]);
+                run_config_child(config, nodes[config.node], fds[1]);
+                _exit(0);
+            }
+            close(fds[1]);
+            busy_sockets[socket] = pid;
+            children[pid] = sweep_child{next, socket, fds[0]};
+            started[next] = true;
+            pending--;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            std::cerr << "waitpid failed: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        auto child = children.find(pid);
+        if (child == children.end()) {
+            continue;
+        }
+        struct sweep_result result = {0, 0};
+        bool received = read(child->second.fd, &result, sizeof(result)) == sizeof(result);
+        close(child->second.fd);
+        bool ok = received && result.ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        failures += ok ? 0 : 1;
+
+        const struct sweep_config &config = configs[child->second.config];
+        results << config.backing << "," << config.pattern << "," << config.width << "," << config.threads << ","
+                << config.node << "," << config.size << "," << config.repeat << ","
+                << (ok ? result.latency : 0) << "," << (ok ? "ok" : "failed") << "\n";
+        results.flush();
+        busy_sockets.erase(child->second.socket);
+        children.erase(child);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// OS 24 EX1
+
+#ifndef _SWEEP_H
+#define _SWEEP_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A single point of the sweep matrix.
+ */
+struct sweep_config {
+    std::string backing;  // malloc, mmap or thp (mmap advised to use transparent huge pages).
+    std::string pattern;  // random or sequential.
+    int width;            // The element width in bytes: 1, 2, 4 or 8.
+    int threads;          // The number of threads measuring concurrently, each on its own array.
+    int node;             // The NUMA node the measurement is pinned to (and so allocates on, by first touch).
+    uint64_t size;        // The array size in bytes.
+    uint64_t repeat;      // The number of iterations of every trial.
+};
+
+
+/**
+ * Parses the sweep matrix from 'key=value,value,...' arguments and expands it into its cartesian product.
+ * Keys that are not given take a single default value.
+ * @param argc - the number of matrix arguments.
+ * @param argv - the matrix arguments.
+ * @param configs - receives the configurations.
+ * @return 0 on success, -1 on an invalid argument.
+ */
+int parse_sweep_matrix(int argc, char *argv[], std::vector<struct sweep_config> &configs);
+
+
+/**
+ * Runs a matrix of configurations, each in a forked child pinned to the cpus of its NUMA node. Configurations on
+ * different sockets run in parallel, configurations sharing a socket run one after the other so they don't disturb
+ * each other through the shared last level cache and memory controller.
+ * Usage: './memory_latency --sweep results_file [key=value,value,... ...]' where the keys are:
+ *      - backing (malloc), pattern (random), width (8), threads (1), node (0), size (1048576), repeat (1000000)
+ *        with their default in parentheses.
+ * Every configuration is measured with the --stable protocol (see measure_with_protocol). All the results are
+ * written to results_file in the following format, in the order the configurations complete:
+ *      backing,pattern,width,threads,node,size,repeat,latency_ns,status
+ * @param argc - the number of arguments following '--sweep'.
+ * @param argv - the arguments following '--sweep'.
+ * @return the process exit code.
+ */
+int run_sweep(int argc, char *argv[]);
+
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Compares the latency of a context switch through sigsetjmp/siglongjmp, which the library used to switch with, and
+ * through contextSwitch. Two contexts on separate stacks switch back and forth, so every round trip is two switches.
+ * Usage: ./context_switch_bench [iterations]
+ */
+#include "../context.h"
+
+#include <chrono>
+#include <csetjmp>
+#include <cstdlib>
+#include <iostream>
+
+#define DEFAULT_ITERATIONS 1000000
+#define PEER_STACK_SIZE (64 * 1024)
+
+static Context mainContext, peerContext;
+static sigjmp_buf mainEnv, peerEnv;
+static char peerStack[PEER_STACK_SIZE];
+
+/**
+ * @brief The peer of the contextSwitch round trips, switching back to main forever.
+ */
+static void contextPeer() {
+    while (true) {
+        contextSwitch(peerContext, mainContext);
+    }
+}
+
+/**
+ * @brief The peer of the sigsetjmp round trips, jumping back to main forever.
+ * It is entered once through contextSwitch, only to get a stack of its own.
+ */
+static void jmpPeer() {
+    while (true) {
+        if (sigsetjmp(peerEnv, 1) == 0) {
+            siglongjmp(mainEnv, 1);
+        }
+    }
+}
+
+/**
+ * @brief Measures round trips between main and the contextSwitch peer.
+ * @param iterations the number of round trips.
+ * @return the time per switch in nanoseconds.
+ */
+static double measureContextSwitch(long iterations) {
+    contextInit(peerContext, peerStack, PEER_STACK_SIZE, &contextPeer);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        contextSwitch(mainContext, peerContext);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (2.0 * iterations);
+}
+
+/**
+ * @brief Measures round trips between main and the sigsetjmp peer, saving the signal mask like the library did.
+ * @param iterations the number of round trips.
+ * @return the time per switch in nanoseconds.
+ */
+static double measureSigsetjmp(long iterations) {
+    contextInit(peerContext, peerStack, PEER_STACK_SIZE, &jmpPeer);
+    if (sigsetjmp(mainEnv, 1) == 0) {
+        contextSwitch(mainContext, peerContext); // the peer sets peerEnv and jumps back.
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (volatile long i = 0; i < iterations; i++) {
+        if (sigsetjmp(mainEnv, 1) == 0) {
+            siglongjmp(peerEnv, 1);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (2.0 * iterations);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+    std::cout << "sigsetjmp/siglongjmp: " << measureSigsetjmp(iterations) << " ns per switch" << std::endl;
+    std::cout << "contextSwitch:        " << measureContextSwitch(iterations) << " ns per switch" << std::endl;
+    return 0;
+}
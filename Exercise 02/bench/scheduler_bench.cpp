@@ -0,0 +1,263 @@
+/*
+ * Measures the scheduler through the public interface of libuthreads.a, and writes the results as JSON:
+ *  - ping_pong_switch_ns: a switch between two threads yielding to each other.
+ *  - spawn_terminate_per_sec: threads spawned, run and terminated per second.
+ *  - block_resume_round_trip_ns: a thread resumed, switched to, blocking itself and switched out.
+ *  - sleep_lateness_us: how much longer than the quantums it asked for a thread sleeps, with a busy main thread.
+ *  - scheduler_switch_ns: a switch with 10, 100, 1k and 10k threads yielding in turn.
+ * The library is initialized once per process, so every measurement runs in a forked child with its own
+ * configuration: cooperative, so no preemption adds noise, but for the sleep one.
+ * Usage: ./scheduler_bench [results_file], the results go to stdout without a results_file.
+ */
+#include "../uthreads.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define PING_PONG_ROUNDS 1000000
+#define SPAWN_ROUNDS 100000
+#define BLOCK_ROUNDS 500000
+#define SLEEP_ROUNDS 200
+#define SLEEP_QUANTUMS 5
+#define SLEEP_QUANTUM_USECS 1000
+#define SCHEDULER_SWITCHES 1000000
+#define MAX_RESULTS 2
+
+static const int threadCounts[] = {10, 100, 1000, 10000};
+
+static volatile int blockedTid;
+static volatile bool sleeperDone;
+
+/**
+ * @brief Initializes the library in a benchmark child.
+ * @param cooperative whether the threads are never preempted.
+ * @param maxThreads the maximal number of concurrent threads.
+ */
+static void initLibrary(bool cooperative, int maxThreads) {
+    struct uthread_config config{};
+    config.cooperative = cooperative;
+    config.quantum_usecs = SLEEP_QUANTUM_USECS;
+    config.wall_clock = 1;
+    config.max_threads = maxThreads;
+    if (uthread_init_ex(&config) < 0) {
+        _exit(1);
+    }
+}
+
+/**
+ * @brief Gets the time since a start point.
+ * @param start the start point.
+ * @return the time in nanoseconds.
+ */
+static double nanosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief A thread yielding forever.
+ */
+static void yielder() {
+    while (true) {
+        uthread_yield();
+    }
+}
+
+/**
+ * @brief A thread terminating at once.
+ */
+static void quitter() {
+    uthread_terminate(uthread_get_tid());
+}
+
+/**
+ * @brief A thread blocking itself every time it is resumed.
+ */
+static void blocker() {
+    blockedTid = uthread_get_tid();
+    while (true) {
+        uthread_block(blockedTid);
+    }
+}
+
+static double *sleepResults; // where the sleeper writes the mean and the maximal lateness in microseconds.
+
+/**
+ * @brief A thread measuring how late it wakes up from its sleeps.
+ */
+static void sleeper() {
+    double sum = 0, max = 0;
+    for (int i = 0; i < SLEEP_ROUNDS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        uthread_sleep(SLEEP_QUANTUMS);
+        double late = nanosSince(start) / 1000 - SLEEP_QUANTUMS * SLEEP_QUANTUM_USECS;
+        sum += late;
+        max = late > max ? late : max;
+    }
+    sleepResults[0] = sum / SLEEP_ROUNDS;
+    sleepResults[1] = max;
+    sleeperDone = true;
+    uthread_terminate(uthread_get_tid());
+}
+
+/**
+ * @brief Measures the switches between main and a thread yielding to each other.
+ * @param results receives the time per switch in nanoseconds.
+ */
+static void pingPong(long, double *results) {
+    initLibrary(true, 2);
+    uthread_spawn(yielder);
+    uthread_yield(); // the first switch to the thread starts it.
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < PING_PONG_ROUNDS; i++) {
+        uthread_yield();
+    }
+    results[0] = nanosSince(start) / (2.0 * PING_PONG_ROUNDS);
+}
+
+/**
+ * @brief Measures threads spawned by main, run and terminated by themselves.
+ * @param results receives the threads per second.
+ */
+static void spawnTerminate(long, double *results) {
+    initLibrary(true, 2);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < SPAWN_ROUNDS; i++) {
+        uthread_spawn(quitter);
+        uthread_yield();
+    }
+    results[0] = SPAWN_ROUNDS / (nanosSince(start) / 1e9);
+}
+
+/**
+ * @brief Measures main resuming a thread and yielding to it, until it blocks itself again.
+ * @param results receives the time per round trip in nanoseconds.
+ */
+static void blockResume(long, double *results) {
+    initLibrary(true, 2);
+    uthread_spawn(blocker);
+    uthread_yield(); // the thread starts and blocks itself.
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < BLOCK_ROUNDS; i++) {
+        uthread_resume(blockedTid);
+        uthread_yield();
+    }
+    results[0] = nanosSince(start) / BLOCK_ROUNDS;
+}
+
+/**
+ * @brief Measures the sleeps of a thread while main keeps the cpu busy, preempted by a wall clock quantum.
+ * @param results receives the mean and the maximal lateness in microseconds.
+ */
+static void sleepLateness(long, double *results) {
+    initLibrary(false, 2);
+    sleepResults = results;
+    uthread_spawn(sleeper);
+    while (!sleeperDone) {}
+}
+
+/**
+ * @brief Measures the switches of a number of threads yielding in turn, with main.
+ * @param threads the number of threads besides main.
+ * @param results receives the time per switch in nanoseconds.
+ */
+static void schedulerSwitch(long threads, double *results) {
+    initLibrary(true, (int) threads + 1);
+    for (long i = 0; i < threads; i++) {
+        if (uthread_spawn(yielder) < 0) {
+            _exit(1);
+        }
+    }
+    uthread_yield(); // the first round starts every thread.
+    long rounds = SCHEDULER_SWITCHES / (threads + 1) + 1;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < rounds; i++) {
+        uthread_yield();
+    }
+    results[0] = nanosSince(start) / ((double) rounds * (threads + 1));
+}
+
+/**
+ * @brief Runs a benchmark in a forked child, which passes its results back through a pipe.
+ * @param benchmark the benchmark.
+ * @param arg the argument of the benchmark.
+ * @param results receives the results, MAX_RESULTS of them.
+ * @return true if the benchmark completed.
+ */
+static bool runInChild(void (*benchmark)(long, double *), long arg, double *results) {
+    fflush(nullptr); // nothing buffered is written twice, by a child exiting on a library error.
+    int fds[2];
+    if (pipe(fds) < 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        double childResults[MAX_RESULTS] = {0};
+        benchmark(arg, childResults);
+        ssize_t written = write(fds[1], childResults, sizeof(childResults));
+        _exit(written == (ssize_t) sizeof(childResults) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t received = read(fds[0], results, MAX_RESULTS * sizeof(double));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    return received == (ssize_t) (MAX_RESULTS * sizeof(double)) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * @brief Runs a benchmark and writes its first result as a JSON value, or null if it failed.
+ * @param out the JSON output.
+ * @param benchmark the benchmark.
+ * @param arg the argument of the benchmark.
+ */
+static void writeResult(FILE *out, void (*benchmark)(long, double *), long arg) {
+    double results[MAX_RESULTS];
+    if (runInChild(benchmark, arg, results)) {
+        fprintf(out, "%.1f", results[0]);
+    } else {
+        fprintf(out, "null");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [results_file]" << std::endl;
+        return 1;
+    }
+    FILE *out = argc == 2 ? fopen(argv[1], "w") : stdout;
+    if (out == nullptr) {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    fprintf(out, "{\n  \"ping_pong_switch_ns\": ");
+    writeResult(out, pingPong, 0);
+    fprintf(out, ",\n  \"spawn_terminate_per_sec\": ");
+    writeResult(out, spawnTerminate, 0);
+    fprintf(out, ",\n  \"block_resume_round_trip_ns\": ");
+    writeResult(out, blockResume, 0);
+    fprintf(out, ",\n  \"sleep_lateness_us\": ");
+    double results[MAX_RESULTS];
+    if (runInChild(sleepLateness, 0, results)) {
+        fprintf(out, "{\"mean\": %.1f, \"max\": %.1f}", results[0], results[1]);
+    } else {
+        fprintf(out, "null");
+    }
+    fprintf(out, ",\n  \"scheduler_switch_ns\": {");
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++) {
+        fprintf(out, "%s\"%d\": ", i == 0 ? "" : ", ", threadCounts[i]);
+        writeResult(out, schedulerSwitch, threadCounts[i]);
+    }
+    fprintf(out, "}\n}\n");
+    return out == stdout || fclose(out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "context.h"
+
+#include <cstdint>
+
+#ifdef UTHREADS_ASM_CONTEXT
+
+#define DEFAULT_MXCSR 0x1F80 /* all SSE exceptions masked, round to nearest */
+#define DEFAULT_FPU_CW 0x037F /* all x87 exceptions masked, round to nearest, extended precision */
+
+/*
+ * uthread_context_switch(void **saveSp, void *loadSp)
+ * Pushes the callee-saved registers, the SSE control/status register and the x87 control word on the current stack,
+ * stores the stack pointer into *saveSp, then pops the same from the loadSp stack and returns into its context.
+ */
+extern "C" void uthread_context_switch(void **saveSp, void *loadSp);
+
+asm(".text\n"
+    ".globl uthread_context_switch\n"
+    ".type uthread_context_switch, @function\n"
+    "uthread_context_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size uthread_context_switch, .-uthread_context_switch\n");
+
+/**
+ * @brief The frame uthread_context_switch pops, from the lowest address up.
+ */
+struct SwitchFrame {
+    uint32_t mxcsr;
+    uint32_t fpuControlWord;
+    uint64_t r15, r14, r13, r12, rbx, rbp;
+    uint64_t returnAddress;
+};
+
+/**
+ * @brief Prepares a context that starts running a function on a stack once it is switched to.
+ * The function must never return.
+ * @param context the context.
+ * @param stack the lowest address of the stack.
+ * @param stackSize the stack size in bytes.
+ * @param entryPoint the function.
+ */
+void contextInit(Context &context, char *stack, size_t stackSize, context_entry_point entryPoint) {
+    // The function is entered by a ret, so the stack must look like right after a call: 8 bytes past a 16 bytes
+    // boundary. It ends on a null return address slot, as entryPoint never returns.
+    auto top = (reinterpret_cast<uintptr_t>(stack + stackSize) & ~static_cast<uintptr_t>(15)) - 16;
+    auto frame = reinterpret_cast<SwitchFrame *>(top - sizeof(SwitchFrame) + sizeof(uint64_t));
+    *frame = SwitchFrame{};
+    frame->mxcsr = DEFAULT_MXCSR;
+    frame->fpuControlWord = DEFAULT_FPU_CW;
+    frame->returnAddress = reinterpret_cast<uint64_t>(entryPoint);
+    context.sp = frame;
+}
+
+/**
+ * @brief Saves the current execution context and resumes another one.
+ * @param save the context to save the current execution into.
+ * @param load the context to resume.
+ */
+void contextSwitch(Context &save, Context &load) {
+    uthread_context_switch(&save.sp, load.sp);
+}
+
+#else
+
+/**
+ * @brief Prepares a context that starts running a function on a stack once it is switched to.
+ * The function must never return.
+ * @param context the context.
+ * @param stack the lowest address of the stack.
+ * @param stackSize the stack size in bytes.
+ * @param entryPoint the function.
+ */
+void contextInit(Context &context, char *stack, size_t stackSize, context_entry_point entryPoint) {
+    getcontext(&context.uc);
+    context.uc.uc_stack.ss_sp = stack;
+    context.uc.uc_stack.ss_size = stackSize;
+    context.uc.uc_link = nullptr;
+    makecontext(&context.uc, entryPoint, 0);
+}
+
+/**
+ * @brief Saves the current execution context and resumes another one.
+ * @param save the context to save the current execution into.
+ * @param load the context to resume.
+ */
+void contextSwitch(Context &save, Context &load) {
+    swapcontext(&save.uc, &load.uc);
+}
+
+#endif
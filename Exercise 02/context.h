@@ -0,0 +1,49 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <cstddef>
+
+/*
+ * On x86-64 the context switch is a hand-written routine that saves only what the System V ABI requires a function
+ * call to preserve, with no system call. Elsewhere (or with UTHREADS_UCONTEXT defined) it falls back to ucontext,
+ * which also saves and restores the signal mask with a system call on every switch.
+ */
+#if defined(__x86_64__) && !defined(UTHREADS_UCONTEXT)
+#define UTHREADS_ASM_CONTEXT
+#else
+#include <ucontext.h>
+#endif
+
+typedef void (*context_entry_point)(void);
+
+/**
+ * @brief The saved execution context of a thread that is not running.
+ */
+struct Context {
+#ifdef UTHREADS_ASM_CONTEXT
+    void *sp; // the saved stack pointer, the callee-saved registers are pushed right below the return address.
+#else
+    ucontext_t uc;
+#endif
+};
+
+/**
+ * @brief Prepares a context that starts running a function on a stack once it is switched to.
+ * The function must never return.
+ * @param context the context.
+ * @param stack the lowest address of the stack.
+ * @param stackSize the stack size in bytes.
+ * @param entryPoint the function.
+ */
+void contextInit(Context &context, char *stack, size_t stackSize, context_entry_point entryPoint);
+
+/**
+ * @brief Saves the current execution context and resumes another one.
+ * Returns when the saved context is switched back to. The signal mask is left untouched on x86-64, so it is up to
+ * the caller to keep it the same across every switch.
+ * @param save the context to save the current execution into.
+ * @param load the context to resume.
+ */
+void contextSwitch(Context &save, Context &load);
+
+#endif // CONTEXT_H
@@ -0,0 +1,155 @@
+#include "fair_queue.h"
+#include "thread.h"
+
+/**
+ * @brief Constructs an empty heap.
+ * @param key the field of the threads the heap is keyed by, the least comes out first.
+ */
+FairQueue::FairQueue(long Thread::*key) : key(key) {}
+
+/**
+ * @brief Adds a thread, keyed by its key field.
+ * @param thread a thread that is in no list.
+ */
+void FairQueue::push(Thread *thread) {
+    thread->fairOrder = pushCount++;
+    thread->fairChild = thread->listPrev = thread->listNext = nullptr;
+    root = root != nullptr ? meld(root, thread) : thread;
+}
+
+/**
+ * @brief Removes the thread with the least key.
+ * @return the thread, the heap must not be empty.
+ */
+Thread *FairQueue::pop() {
+    Thread *thread = root;
+    root = mergePairs(thread->fairChild);
+    thread->fairChild = nullptr;
+    return thread;
+}
+
+/**
+ * @brief Removes a thread from the heap.
+ * @param thread a thread in the heap.
+ */
+void FairQueue::remove(Thread *thread) {
+    if (thread == root) {
+        pop();
+        return;
+    }
+    if (thread->listPrev->fairChild == thread) { // a first child, listPrev is its parent.
+        thread->listPrev->fairChild = thread->listNext;
+    } else {
+        thread->listPrev->listNext = thread->listNext;
+    }
+    if (thread->listNext != nullptr) {
+        thread->listNext->listPrev = thread->listPrev;
+    }
+    Thread *children = mergePairs(thread->fairChild);
+    thread->fairChild = thread->listPrev = thread->listNext = nullptr;
+    if (children != nullptr) {
+        root = meld(root, children);
+    }
+}
+
+/**
+ * @brief Get the thread with the least key.
+ * @return the thread, the heap must not be empty.
+ */
+Thread *FairQueue::top() const {
+    return root;
+}
+
+/**
+ * @brief Checks if the heap is empty.
+ * @return true if no thread is in the heap.
+ */
+bool FairQueue::empty() const {
+    return root == nullptr;
+}
+
+/**
+ * @brief Removes all the threads.
+ */
+void FairQueue::clear() {
+    unlinkAll(root);
+    root = nullptr;
+}
+
+/**
+ * @brief Checks if a thread comes out of the heap before another.
+ * @param a a thread.
+ * @param b another thread.
+ * @return true if a has a smaller key, or an equal one and was pushed earlier.
+ */
+bool FairQueue::before(const Thread *a, const Thread *b) const {
+    return a->*key != b->*key ? a->*key < b->*key : a->fairOrder < b->fairOrder;
+}
+
+/**
+ * @brief Links two heaps, the root that comes out later becomes the first child of the other.
+ * @param a the root of a heap, with no siblings.
+ * @param b the root of another heap, with no siblings.
+ * @return the root of the linked heap.
+ */
+Thread *FairQueue::meld(Thread *a, Thread *b) const {
+    if (before(b, a)) {
+        Thread *swap = a;
+        a = b;
+        b = swap;
+    }
+    b->listPrev = a;
+    b->listNext = a->fairChild;
+    if (a->fairChild != nullptr) {
+        a->fairChild->listPrev = b;
+    }
+    a->fairChild = b;
+    return a;
+}
+
+/**
+ * @brief Links a list of siblings into one heap, in two passes: pairs from the left, then the pairs from the right.
+ * @param first the first sibling, or nullptr.
+ * @return the root of the heap, with no siblings, or nullptr.
+ */
+Thread *FairQueue::mergePairs(Thread *first) const {
+    Thread *pairs = nullptr; // the linked pairs, the last one first, chained through listNext.
+    while (first != nullptr) {
+        Thread *a = first;
+        Thread *b = a->listNext;
+        first = b != nullptr ? b->listNext : nullptr;
+        a->listPrev = a->listNext = nullptr;
+        if (b != nullptr) {
+            b->listPrev = b->listNext = nullptr;
+            a = meld(a, b);
+        }
+        a->listNext = pairs;
+        pairs = a;
+    }
+    if (pairs == nullptr) {
+        return nullptr;
+    }
+    Thread *heap = pairs;
+    pairs = pairs->listNext;
+    heap->listNext = nullptr;
+    while (pairs != nullptr) {
+        Thread *next = pairs->listNext;
+        pairs->listNext = nullptr;
+        heap = meld(heap, pairs);
+        pairs = next;
+    }
+    return heap;
+}
+
+/**
+ * @brief Unlinks the threads of a subtree.
+ * @param thread the root of the subtree, or nullptr.
+ */
+void FairQueue::unlinkAll(Thread *thread) {
+    while (thread != nullptr) {
+        unlinkAll(thread->fairChild);
+        Thread *next = thread->listNext;
+        thread->fairChild = thread->listPrev = thread->listNext = nullptr;
+        thread = next;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef FAIR_QUEUE_H
+#define FAIR_QUEUE_H
+
+class Thread;
+
+/**
+ * @brief The FairQueue class is a pairing heap of the ready threads, keyed by a field of the threads: their virtual
+ * runtime for the fair share policy, or their deadline for the periodic threads. Threads of equal keys come out in
+ * the order they were pushed. The heap is intrusive,
+ * linked through the fairChild, listPrev and listNext of the threads: listNext is the next sibling and listPrev the
+ * previous sibling, or the parent of a first child. Pushing takes O(1), popping and removing O(log n) amortized.
+ */
+class FairQueue {
+public:
+    /**
+     * @brief Constructs an empty heap.
+     * @param key the field of the threads the heap is keyed by, the least comes out first.
+     */
+    explicit FairQueue(long Thread::*key);
+
+    /**
+     * @brief Adds a thread, keyed by its key field.
+     * @param thread a thread that is in no list.
+     */
+    void push(Thread *thread);
+
+    /**
+     * @brief Removes the thread with the least key.
+     * @return the thread, the heap must not be empty.
+     */
+    Thread *pop();
+
+    /**
+     * @brief Removes a thread from the heap.
+     * @param thread a thread in the heap.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * @brief Get the thread with the least key.
+     * @return the thread, the heap must not be empty.
+     */
+    Thread *top() const;
+
+    /**
+     * @brief Checks if the heap is empty.
+     * @return true if no thread is in the heap.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Removes all the threads.
+     */
+    void clear();
+
+private:
+    long Thread::*key;
+    Thread *root = nullptr;
+    unsigned long pushCount = 0; // the order of the pushes, which breaks the ties between equal vruntimes.
+
+    /**
+     * @brief Checks if a thread comes out of the heap before another.
+     * @param a a thread.
+     * @param b another thread.
+     * @return true if a has a smaller key, or an equal one and was pushed earlier.
+     */
+    bool before(const Thread *a, const Thread *b) const;
+
+    /**
+     * @brief Links two heaps, the root that comes out later becomes the first child of the other.
+     * @param a the root of a heap, with no siblings.
+     * @param b the root of another heap, with no siblings.
+     * @return the root of the linked heap.
+     */
+    Thread *meld(Thread *a, Thread *b) const;
+
+    /**
+     * @brief Links a list of siblings into one heap, in two passes: pairs from the left, then the pairs from the right.
+     * @param first the first sibling, or nullptr.
+     * @return the root of the heap, with no siblings, or nullptr.
+     */
+    Thread *mergePairs(Thread *first) const;
+
+    /**
+     * @brief Unlinks the threads of a subtree.
+     * @param thread the root of the subtree, or nullptr.
+     */
+    static void unlinkAll(Thread *thread);
+};
+
+#endif // FAIR_QUEUE_H
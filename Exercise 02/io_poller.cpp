@@ -0,0 +1,124 @@
+#include "io_poller.h"
+#include "thread.h"
+
+#include <cerrno>
+#include <sys/epoll.h>
+
+#define MAX_EVENTS 64
+
+/**
+ * @brief Constructor for the IoPoller class. The epoll instance is only created by the first wait.
+ */
+IoPoller::IoPoller() : epollFd(-1) {}
+
+/**
+ * @brief Checks if a thread already waits on a file descriptor in a direction.
+ * @param fd the file descriptor.
+ * @param write true for writing, false for reading.
+ * @return true if there is a waiter.
+ */
+bool IoPoller::isWaitedOn(int fd, bool write) const {
+    auto it = waiters.find(fd);
+    return it != waiters.end() && (write ? it->second.writer : it->second.reader) != nullptr;
+}
+
+/**
+ * @brief Adds a waiter, the file descriptor must not be waited on in that direction.
+ * @param thread the thread.
+ * @param fd the file descriptor.
+ * @param write true to wait until it is writable, false until it is readable.
+ * @return 0 on success, -1 with errno set if epoll has failed.
+ */
+int IoPoller::add(Thread *thread, int fd, bool write) {
+    if (epollFd == -1) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1) {
+            return -1;
+        }
+    }
+    auto it = waiters.find(fd);
+    bool registered = it != waiters.end();
+    Waiters &entry = registered ? it->second : waiters[fd];
+    if (!registered) {
+        entry = Waiters{nullptr, nullptr};
+    }
+    (write ? entry.writer : entry.reader) = thread;
+    if (update(fd, registered) < 0) {
+        (write ? entry.writer : entry.reader) = nullptr;
+        if (!registered) {
+            waiters.erase(fd);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Removes a waiter.
+ * @param thread a thread waiting on its ioFd.
+ */
+void IoPoller::remove(Thread *thread) {
+    Waiters &entry = waiters[thread->ioFd];
+    if (entry.reader == thread) {
+        entry.reader = nullptr;
+    }
+    if (entry.writer == thread) {
+        entry.writer = nullptr;
+    }
+    update(thread->ioFd, true); // can only fail if the file descriptor was closed, which unregistered it already.
+}
+
+/**
+ * @brief Checks if any thread is waiting.
+ * @return true if there is a waiter.
+ */
+bool IoPoller::hasWaiters() const {
+    return !waiters.empty();
+}
+
+/**
+ * @brief Waits for the waited on file descriptors, and removes the waiters of those that are ready.
+ * An error or a hang up wakes both waiters of a file descriptor, their I/O call reports it.
+ * @param timeoutMs the longest time to wait in milliseconds, 0 to poll and -1 to wait for an event.
+ * @param ready receives the removed waiters.
+ * @return 0 on success, -1 with errno set if epoll has failed.
+ */
+int IoPoller::wait(int timeoutMs, std::vector<Thread *> &ready) {
+    struct epoll_event events[MAX_EVENTS];
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        Waiters &entry = waiters[fd];
+        if (entry.reader != nullptr && (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+            ready.push_back(entry.reader);
+            entry.reader = nullptr;
+        }
+        if (entry.writer != nullptr && (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            ready.push_back(entry.writer);
+            entry.writer = nullptr;
+        }
+        update(fd, true);
+    }
+    return 0;
+}
+
+/**
+ * @brief Registers the events a file descriptor's waiters wait for, or unregisters it if it has none left.
+ * @param fd the file descriptor.
+ * @param registered true if the file descriptor is already registered.
+ * @return 0 on success, -1 with errno set if epoll has failed.
+ */
+int IoPoller::update(int fd, bool registered) {
+    const Waiters &entry = waiters[fd];
+    if (entry.reader == nullptr && entry.writer == nullptr) {
+        waiters.erase(fd);
+        return epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    struct epoll_event event{};
+    event.events = (entry.reader != nullptr ? EPOLLIN : 0) | (entry.writer != nullptr ? EPOLLOUT : 0);
+    event.data.fd = fd;
+    return epoll_ctl(epollFd, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+}
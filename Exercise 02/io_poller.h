@@ -0,0 +1,81 @@
+#ifndef IO_POLLER_H
+#define IO_POLLER_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+class Thread;
+
+/**
+ * @brief The IoPoller class tracks the threads waiting for a file descriptor to become readable or writable, with an
+ * epoll instance holding the file descriptors they wait on. A file descriptor has at most one reading and one writing
+ * waiter, and is only registered while it has one.
+ */
+class IoPoller {
+public:
+    /**
+     * @brief Constructor for the IoPoller class. The epoll instance is only created by the first wait.
+     */
+    IoPoller();
+
+    /**
+     * @brief Checks if a thread already waits on a file descriptor in a direction.
+     * @param fd the file descriptor.
+     * @param write true for writing, false for reading.
+     * @return true if there is a waiter.
+     */
+    bool isWaitedOn(int fd, bool write) const;
+
+    /**
+     * @brief Adds a waiter, the file descriptor must not be waited on in that direction.
+     * @param thread the thread.
+     * @param fd the file descriptor.
+     * @param write true to wait until it is writable, false until it is readable.
+     * @return 0 on success, -1 with errno set if epoll has failed.
+     */
+    int add(Thread *thread, int fd, bool write);
+
+    /**
+     * @brief Removes a waiter.
+     * @param thread a thread waiting on its ioFd.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * @brief Checks if any thread is waiting.
+     * @return true if there is a waiter.
+     */
+    bool hasWaiters() const;
+
+    /**
+     * @brief Waits for the waited on file descriptors, and removes the waiters of those that are ready.
+     * An error or a hang up wakes both waiters of a file descriptor, their I/O call reports it.
+     * @param timeoutMs the longest time to wait in milliseconds, 0 to poll and -1 to wait for an event.
+     * @param ready receives the removed waiters.
+     * @return 0 on success, -1 with errno set if epoll has failed.
+     */
+    int wait(int timeoutMs, std::vector<Thread *> &ready);
+
+private:
+    /**
+     * @brief The waiters of a file descriptor, nullptr for none.
+     */
+    struct Waiters {
+        Thread *reader;
+        Thread *writer;
+    };
+
+    int epollFd;
+    std::unordered_map<int, Waiters> waiters;
+
+    /**
+     * @brief Registers the events a file descriptor's waiters wait for, or unregisters it if it has none left.
+     * @param fd the file descriptor.
+     * @param registered true if the file descriptor is already registered.
+     * @return 0 on success, -1 with errno set if epoll has failed.
+     */
+    int update(int fd, bool registered);
+};
+
+#endif // IO_POLLER_H
@@ -0,0 +1,115 @@
+#include "sleep_queue.h"
+#include "thread.h"
+
+/**
+ * @brief Adds a thread, keyed by its wakeQuantum.
+ * @param thread the thread.
+ */
+void SleepQueue::push(Thread *thread) {
+    heap.push_back(thread);
+    place(heap.size() - 1, thread);
+    siftUp(heap.size() - 1);
+}
+
+/**
+ * @brief Removes the thread with the earliest wakeQuantum.
+ * @return the thread.
+ */
+Thread *SleepQueue::pop() {
+    Thread *thread = heap.front();
+    remove(thread);
+    return thread;
+}
+
+/**
+ * @brief Removes a thread from the heap.
+ * @param thread a thread currently in the heap.
+ */
+void SleepQueue::remove(Thread *thread) {
+    size_t index = thread->sleepIndex;
+    Thread *last = heap.back();
+    heap.pop_back();
+    thread->sleepIndex = NOT_SLEEPING;
+    if (last == thread) {
+        return;
+    }
+    place(index, last);
+    siftUp(index);
+    siftDown(last->sleepIndex);
+}
+
+/**
+ * @brief Get the thread with the earliest wakeQuantum.
+ * @return the thread, the heap must not be empty.
+ */
+Thread *SleepQueue::top() const {
+    return heap.front();
+}
+
+/**
+ * @brief Checks if the heap is empty.
+ * @return true if no thread is sleeping.
+ */
+bool SleepQueue::empty() const {
+    return heap.empty();
+}
+
+/**
+ * @brief Removes all the threads.
+ */
+void SleepQueue::clear() {
+    for (Thread *thread: heap) {
+        thread->sleepIndex = NOT_SLEEPING;
+    }
+    heap.clear();
+}
+
+/**
+ * @brief Moves the thread at a position up until its parent wakes up earlier.
+ * @param index the position.
+ */
+void SleepQueue::siftUp(size_t index) {
+    Thread *thread = heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap[parent]->wakeQuantum <= thread->wakeQuantum) {
+            break;
+        }
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, thread);
+}
+
+/**
+ * @brief Moves the thread at a position down until its children wake up later.
+ * @param index the position.
+ */
+void SleepQueue::siftDown(size_t index) {
+    Thread *thread = heap[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= heap.size()) {
+            break;
+        }
+        if (child + 1 < heap.size() && heap[child + 1]->wakeQuantum < heap[child]->wakeQuantum) {
+            child++;
+        }
+        if (thread->wakeQuantum <= heap[child]->wakeQuantum) {
+            break;
+        }
+        place(index, heap[child]);
+        index = child;
+    }
+    place(index, thread);
+}
+
+/**
+ * @brief Places a thread at a position of the heap.
+ * @param index the position.
+ * @param thread the thread.
+ */
+void SleepQueue::place(size_t index, Thread *thread) {
+    heap[index] = thread;
+    thread->sleepIndex = static_cast<int>(index);
+}
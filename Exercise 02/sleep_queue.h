@@ -0,0 +1,73 @@
+#ifndef SLEEP_QUEUE_H
+#define SLEEP_QUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+class Thread;
+
+/**
+ * @brief The SleepQueue class is a binary min-heap of the sleeping threads, keyed by the quantum they wake up at.
+ * Every thread stores its own position in the heap, so it can be removed in O(log n) when it is terminated.
+ */
+class SleepQueue {
+public:
+    /**
+     * @brief Adds a thread, keyed by its wakeQuantum.
+     * @param thread the thread.
+     */
+    void push(Thread *thread);
+
+    /**
+     * @brief Removes the thread with the earliest wakeQuantum.
+     * @return the thread.
+     */
+    Thread *pop();
+
+    /**
+     * @brief Removes a thread from the heap.
+     * @param thread a thread currently in the heap.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * @brief Get the thread with the earliest wakeQuantum.
+     * @return the thread, the heap must not be empty.
+     */
+    Thread *top() const;
+
+    /**
+     * @brief Checks if the heap is empty.
+     * @return true if no thread is sleeping.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Removes all the threads.
+     */
+    void clear();
+
+private:
+    std::vector<Thread *> heap;
+
+    /**
+     * @brief Moves the thread at a position up until its parent wakes up earlier.
+     * @param index the position.
+     */
+    void siftUp(size_t index);
+
+    /**
+     * @brief Moves the thread at a position down until its children wake up later.
+     * @param index the position.
+     */
+    void siftDown(size_t index);
+
+    /**
+     * @brief Places a thread at a position of the heap.
+     * @param index the position.
+     * @param thread the thread.
+     */
+    void place(size_t index, Thread *thread);
+};
+
+#endif // SLEEP_QUEUE_H
@@ -0,0 +1,92 @@
+#include "stack_pool.h"
+
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief Gets the stack space a signal frame may take on this cpu.
+ * @return the size in bytes.
+ */
+static size_t querySignalFrameSize() {
+#ifdef _SC_MINSIGSTKSZ
+    long size = sysconf(_SC_MINSIGSTKSZ);
+    if (size > 0) {
+        return size;
+    }
+#endif
+    return MINSIGSTKSZ;
+}
+
+/**
+ * @brief Constructor for the StackPool class.
+ */
+StackPool::StackPool() : pageSize(sysconf(_SC_PAGESIZE)), signalFrameSize(querySignalFrameSize()) {}
+
+/**
+ * @brief Rounds a stack size up to the size of the stacks the pool hands out for it.
+ * The preemption signal is delivered on the thread stack, so room for a signal frame is added on top of the
+ * requested size.
+ * @param size the requested stack size in bytes.
+ * @return the stack size in bytes, a multiple of the page size.
+ */
+size_t StackPool::roundSize(size_t size) const {
+    return (size + signalFrameSize + pageSize - 1) / pageSize * pageSize;
+}
+
+/**
+ * @brief Hands out a stack.
+ * @param size the stack size in bytes, as returned by roundSize.
+ * @return the lowest address of the stack, or nullptr if mapping a new stack has failed.
+ */
+char *StackPool::allocate(size_t size) {
+    std::vector<char *> &stacks = freeStacks[size];
+    if (!stacks.empty()) {
+        char *stack = stacks.back();
+        stacks.pop_back();
+        return stack;
+    }
+    void *mapping = mmap(nullptr, pageSize + size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    if (mprotect(mapping, pageSize, PROT_NONE) < 0) { // stacks grow down, so the guard page is the lowest one.
+        munmap(mapping, pageSize + size);
+        return nullptr;
+    }
+    return static_cast<char *>(mapping) + pageSize;
+}
+
+/**
+ * @brief Returns a stack to the pool, giving its pages back to the kernel but for its top one, which every thread
+ * uses.
+ * @param stack the stack, as returned by allocate.
+ * @param size the stack size it was allocated with.
+ */
+void StackPool::release(char *stack, size_t size) {
+    if (size > pageSize) { // the pages the thread never touched are not committed, and dropping them costs nothing.
+        madvise(stack, size - pageSize, MADV_DONTNEED);
+    }
+    freeStacks[size].push_back(stack);
+}
+
+/**
+ * @brief Measures how deep a stack has been used, from its lowest committed page, as stacks grow down.
+ * @param stack the stack, as returned by allocate.
+ * @param size the stack size it was allocated with.
+ * @return the bytes from the lowest committed page to the top of the stack, 0 if none is committed or the
+ * measurement failed.
+ */
+size_t StackPool::highWaterMark(const char *stack, size_t size) const {
+    std::vector<unsigned char> resident(size / pageSize);
+    if (mincore(const_cast<char *>(stack), size, resident.data()) < 0) {
+        return 0;
+    }
+    for (size_t page = 0; page < resident.size(); page++) {
+        if (resident[page] & 1) {
+            return size - page * pageSize;
+        }
+    }
+    return 0;
+}
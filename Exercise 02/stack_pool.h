@@ -0,0 +1,62 @@
+#ifndef STACK_POOL_H
+#define STACK_POOL_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The StackPool class hands out thread stacks mapped with mmap, each right above a PROT_NONE guard page so a
+ * stack overflow faults instead of overwriting the memory below it.
+ * Released stacks are kept in a free list per size and handed out again, so spawning and terminating threads does not
+ * map and unmap memory once the pool is warm.
+ * Stacks are mapped with MAP_NORESERVE, so a large stack only reserves address space: the kernel commits its pages as
+ * the thread touches them, and the pages a stack used are given back when it returns to the pool.
+ */
+class StackPool {
+public:
+    /**
+     * @brief Constructor for the StackPool class.
+     */
+    StackPool();
+
+    /**
+     * @brief Rounds a stack size up to the size of the stacks the pool hands out for it.
+     * The preemption signal is delivered on the thread stack, so room for a signal frame is added on top of the
+     * requested size (the frame holds the extended register state, which takes kilobytes on recent x86-64 cpus).
+     * @param size the requested stack size in bytes.
+     * @return the stack size in bytes, a multiple of the page size.
+     */
+    size_t roundSize(size_t size) const;
+
+    /**
+     * @brief Hands out a stack.
+     * @param size the stack size in bytes, as returned by roundSize.
+     * @return the lowest address of the stack, or nullptr if mapping a new stack has failed.
+     */
+    char *allocate(size_t size);
+
+    /**
+     * @brief Returns a stack to the pool, giving its pages back to the kernel but for its top one, which every
+     * thread uses.
+     * @param stack the stack, as returned by allocate.
+     * @param size the stack size it was allocated with.
+     */
+    void release(char *stack, size_t size);
+
+    /**
+     * @brief Measures how deep a stack has been used, from its lowest committed page, as stacks grow down.
+     * @param stack the stack, as returned by allocate.
+     * @param size the stack size it was allocated with.
+     * @return the bytes from the lowest committed page to the top of the stack, 0 if none is committed or the
+     * measurement failed.
+     */
+    size_t highWaterMark(const char *stack, size_t size) const;
+
+private:
+    size_t pageSize;
+    size_t signalFrameSize;
+    std::unordered_map<size_t, std::vector<char *>> freeStacks; // stack size to its released stacks.
+};
+
+#endif // STACK_POOL_H
@@ -0,0 +1,35 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+void batch()
+{
+  printf ("%d ", uthread_get_tid());
+  uthread_terminate (uthread_get_tid());
+}
+
+void handler()
+{
+  printf ("%d ", uthread_get_tid());
+  uthread_block (uthread_get_tid());
+  printf ("%d ", uthread_get_tid());
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.cooperative = 1;
+  uthread_init_ex (&config);
+  int batchTid = uthread_spawn_prio (batch, 5);
+  int handlerTid = uthread_spawn_prio (handler, 0);
+  printf ("%d ", uthread_get_tid());
+  uthread_set_priority (0, 3);   // the handler outranks main now
+  printf ("%d ", uthread_get_tid());
+  uthread_resume (handlerTid);   // runs right away
+  printf ("%d ", uthread_get_tid());
+  uthread_yield ();              // the batch thread is ranked lower, main goes on
+  uthread_set_priority (batchTid, 1);
+  printf ("%d ", uthread_get_tid());
+  printf ("\nYou should see: 0 2 0 2 0 1 0\n");
+  uthread_terminate(0);
+}
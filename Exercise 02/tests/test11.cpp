@@ -0,0 +1,46 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+#define THREADS 8
+#define ITERATIONS 1000000
+
+volatile int counts[THREADS + 1];
+
+void counter()
+{
+  int tid = uthread_get_tid();
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    counts[tid]++;
+  }
+  uthread_terminate (tid);
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.quantum_usecs = 1000;
+  config.workers = 4;
+  uthread_init_ex (&config);
+  for (int i = 0; i < THREADS; i++)
+  {
+    uthread_spawn (counter);
+  }
+  uthread_block (1);             // possibly running on another worker
+  long total = 0;
+  while (total != (long) (THREADS - 1) * ITERATIONS)   // every thread but the blocked one, on any worker
+  {
+    total = 0;
+    for (int tid = 2; tid <= THREADS; tid++)
+    {
+      total += counts[tid];
+    }
+  }
+  uthread_resume (1);
+  while (counts[1] != ITERATIONS)
+  {
+  }
+  printf ("%ld %d\n", total, counts[1]);
+  printf ("\nYou should see: 7000000 1000000\n");
+  uthread_terminate(0);
+}
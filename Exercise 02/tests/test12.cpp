@@ -0,0 +1,57 @@
+#include "uthreads.h"
+#include "stdio.h"
+#include <netinet/in.h>
+#include <unistd.h>
+
+int pipeFds[2];
+int listenFd;
+
+void reader()
+{
+  char buf[8] = {};
+  printf ("%d ", uthread_get_tid());
+  uthread_read (pipeFds[0], buf, 4);   // parks until main writes
+  printf ("%s ", buf);
+  uthread_terminate (uthread_get_tid());
+}
+
+void server()
+{
+  char buf[8] = {};
+  printf ("%d ", uthread_get_tid());
+  int client = uthread_accept (listenFd, nullptr, nullptr);   // parks until main connects
+  uthread_read (client, buf, 4);
+  printf ("%s ", buf);
+  close (client);
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.cooperative = 1;
+  uthread_init_ex (&config);
+  pipe (pipeFds);
+  listenFd = socket (AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  socklen_t length = sizeof (address);
+  bind (listenFd, (struct sockaddr *) &address, length);
+  getsockname (listenFd, (struct sockaddr *) &address, &length);
+  listen (listenFd, 1);
+
+  uthread_spawn (reader);
+  uthread_spawn (server);
+  uthread_yield ();               // both park
+  printf ("%d ", uthread_get_tid());
+  uthread_write (pipeFds[1], "pipe", 4);
+  uthread_yield ();               // the reader wakes up
+  int client = socket (AF_INET, SOCK_STREAM, 0);
+  connect (client, (struct sockaddr *) &address, length);
+  uthread_write (client, "sock", 4);
+  uthread_yield ();               // the server wakes up
+  printf ("%d ", uthread_get_tid());
+  printf ("\nYou should see: 1 2 0 pipe sock 0\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,76 @@
+#include "uthreads.h"
+#include "stdio.h"
+#include <stdint.h>
+
+#define ITEMS 1000
+#define COUNTERS 4
+#define INCREMENTS 100000
+
+uthread_chan_t chan;
+uthread_mutex_t mutex = UTHREAD_MUTEX_INITIALIZER;
+uthread_cond_t allDone = UTHREAD_COND_INITIALIZER;
+long counter = 0;
+long received = 0;
+int done = 0;
+
+void finish()
+{
+  uthread_mutex_lock (&mutex);
+  done++;
+  uthread_cond_signal (&allDone);
+  uthread_mutex_unlock (&mutex);
+  uthread_terminate (uthread_get_tid());
+}
+
+void producer()
+{
+  for (intptr_t i = 1; i <= ITEMS; i++)
+  {
+    uthread_chan_send (&chan, (void *) i);
+  }
+  uthread_chan_send (&chan, nullptr);
+  finish();
+}
+
+void consumer()
+{
+  void *item;
+  for (uthread_chan_recv (&chan, &item); item != nullptr; uthread_chan_recv (&chan, &item))
+  {
+    received += (intptr_t) item;
+  }
+  finish();
+}
+
+void incrementer()
+{
+  for (int i = 0; i < INCREMENTS; i++)   // preempted with the mutex held now and then
+  {
+    uthread_mutex_lock (&mutex);
+    counter++;
+    uthread_mutex_unlock (&mutex);
+  }
+  finish();
+}
+
+int main(int argc, char **argv)
+{
+  uthread_init (100);
+  uthread_chan_init (&chan, 4);
+  uthread_spawn (producer);
+  uthread_spawn (consumer);
+  for (int i = 0; i < COUNTERS; i++)
+  {
+    uthread_spawn (incrementer);
+  }
+  uthread_mutex_lock (&mutex);
+  while (done != COUNTERS + 2)
+  {
+    uthread_cond_wait (&allDone, &mutex);
+  }
+  uthread_mutex_unlock (&mutex);
+  uthread_chan_destroy (&chan);
+  printf ("%ld %ld\n", received, counter);
+  printf ("\nYou should see: 500500 400000\n");
+  uthread_terminate(0);
+}
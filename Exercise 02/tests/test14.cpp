@@ -0,0 +1,28 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+volatile int done = 0;
+
+void f()
+{
+  printf ("%d ", uthread_get_tid());
+  uthread_sleep (2);             // main alone, but the quantums must go on for f to wake up
+  printf ("%d ", uthread_get_tid());
+  done = 1;
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.quantum_usecs = 1000;
+  config.wall_clock = 1;
+  uthread_init_ex (&config);
+  while (uthread_get_total_quantums() < 5) {}   // alone, with no timer running
+  printf ("%d ", uthread_get_quantums (0) >= 5 ? 0 : -1);
+  uthread_spawn (f);
+  while (!done) {}
+  printf ("%d ", uthread_get_tid());
+  printf ("\nYou should see: 0 1 1 0\n");
+  uthread_terminate(0);
+}
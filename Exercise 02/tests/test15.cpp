@@ -0,0 +1,36 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+void f()
+{
+  uthread_yield ();
+  uthread_terminate (uthread_get_tid());
+}
+
+long long total (const long long *histogram)
+{
+  long long sum = 0;
+  for (int i = 0; i < UTHREAD_STATS_BUCKETS; i++)
+  {
+    sum += histogram[i];
+  }
+  return sum;
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.cooperative = 1;
+  uthread_init_ex (&config);
+  int tid = uthread_spawn (f);
+  uthread_yield ();                 // f runs and yields back
+  struct uthread_stats stats;
+  uthread_get_stats (tid, &stats);
+  printf ("%lld ", stats.voluntary_switches);
+  uthread_yield ();                 // f runs and terminates
+  uthread_get_stats (-1, &stats);   // main switched out twice and in twice, f out once and in twice
+  printf ("%lld %lld %lld ", stats.voluntary_switches, stats.involuntary_switches, total (stats.switch_latency));
+  printf ("%d ", stats.run_nsec > 0 && stats.ready_nsec > 0);
+  printf ("\nYou should see: 1 3 0 4 1\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,36 @@
+#include "uthreads.h"
+#include "../trace.h"
+#include "stdio.h"
+
+void f()
+{
+  uthread_yield ();
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.cooperative = 1;
+  config.trace_events = 100;
+  uthread_init_ex (&config);
+  int tid = uthread_spawn (f);     // spawn
+  uthread_yield ();                 // main out, f in, f out, main in
+  uthread_yield ();                 // main out, f in, f terminates, main in
+  printf ("%d ", uthread_trace_dump ("/tmp/uthreads_test16.trace"));
+  FILE *file = fopen ("/tmp/uthreads_test16.trace", "rb");
+  TraceFileHeader header;
+  fread (&header, sizeof(header), 1, file);
+  TraceEvent events[100];
+  int count = (int) fread (events, sizeof(TraceEvent), 100, file);
+  fclose (file);
+  int spawned = 0, in = 0;
+  for (int i = 0; i < count; i++)
+  {
+    spawned += events[i].type == TRACE_SPAWN && events[i].tid == tid;
+    in += events[i].type == TRACE_SWITCH_IN && events[i].tid == tid;
+  }
+  printf ("%d %d %d %d", count, (int) header.eventCount, spawned, in);
+  printf ("\nYou should see: 0 9 9 1 2\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,29 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+void spin()
+{
+  while (1)
+  {
+  }
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.policy = 3;
+  printf ("%d ", uthread_init_ex (&config));
+  config.policy = UTHREAD_POLICY_FAIR;
+  config.quantum_usecs = 1000;
+  printf ("%d ", uthread_init_ex (&config));
+  int heavy = uthread_spawn_prio (spin, 0);
+  int light = uthread_spawn_prio (spin, 7);
+  while (uthread_get_total_quantums () < 300)
+  {
+  }                                 // main and the spinners share the cpu by weight, 1024, 1024 and 215
+  int heavyQuantums = uthread_get_quantums (heavy);
+  int lightQuantums = uthread_get_quantums (light);
+  printf ("%d %d", lightQuantums > 0, heavyQuantums > 3 * lightQuantums);
+  printf ("\nYou should see: -1 0 1 1\n");
+  uthread_terminate(0);
+}
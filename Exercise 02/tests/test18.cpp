@@ -0,0 +1,56 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+void spin()
+{
+  while (1)
+  {
+  }
+}
+
+void nap()
+{
+  while (1)
+  {
+    uthread_sleep (1);
+  }
+}
+
+int quantum ()
+{
+  struct uthread_stats stats;
+  uthread_get_stats (-1, &stats);
+  return (int) stats.quantum_usecs;
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.quantum_usecs = 1000;
+  config.quantum_max_usecs = 4000;
+  printf ("%d ", uthread_init_ex (&config));
+  config.quantum_min_usecs = 200;
+  printf ("%d ", uthread_init_ex (&config));
+  int spinners[8];
+  for (int i = 0; i < 8; i++)
+  {
+    spinners[i] = uthread_spawn (spin);
+  }
+  int start = uthread_get_total_quantums ();
+  while (uthread_get_total_quantums () < start + 50)
+  {
+  }                                 // 8 READY spinners, each quantum is 1000 / 8 clamped to 200
+  printf ("%d ", quantum ());
+  for (int i = 0; i < 8; i++)
+  {
+    uthread_terminate (spinners[i]);
+  }
+  uthread_spawn (nap);
+  start = uthread_get_total_quantums ();
+  while (uthread_get_total_quantums () < start + 200)
+  {
+  }                                 // the napper gives up the cpu early, main's quantum grows
+  printf ("%d", quantum () > 1000);
+  printf ("\nYou should see: -1 0 200 1\n");
+  uthread_terminate(0);
+}
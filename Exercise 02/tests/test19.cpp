@@ -0,0 +1,48 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+int samples = 0;
+
+void spin()
+{
+  while (1)
+  {
+  }
+}
+
+void sampler()
+{
+  while (1)
+  {
+    samples++;
+    uthread_wait_period ();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.quantum_usecs = 1000;
+  uthread_init_ex (&config);
+  for (int i = 0; i < 4; i++)
+  {
+    uthread_spawn (spin);
+  }
+  printf ("%d ", uthread_spawn_periodic (sampler, 2, 3));
+  int start = uthread_get_total_quantums ();
+  int tid = uthread_spawn_periodic (sampler, 5, 1);   // runs at once, ahead of the spinners
+  printf ("%d ", samples > 0);
+  int hog = uthread_spawn_periodic (spin, 10, 4);     // utilization 0.2 + 0.4, no room left for 0.5
+  printf ("%d ", uthread_spawn_periodic (sampler, 2, 1));
+  while (uthread_get_total_quantums () < start + 100)
+  {
+  }
+  int periods = (uthread_get_total_quantums () - start) / 5;
+  struct uthread_stats stats;
+  uthread_get_stats (tid, &stats);
+  printf ("%d %lld ", samples >= periods - 1 && samples <= periods + 1, stats.deadline_misses);
+  uthread_get_stats (hog, &stats);                    // the hog misses every deadline, throttled at 4 quantums
+  printf ("%d %d", stats.deadline_misses >= periods / 2 - 2, uthread_get_quantums (hog) <= 4 * (periods / 2 + 1));
+  printf ("\nYou should see: -1 1 -1 1 0 1 1\n");
+  uthread_terminate(0);
+}
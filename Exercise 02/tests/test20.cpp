@@ -0,0 +1,38 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+#define DEEP (128 * 1024)
+#define SHALLOW_MAX (32 * 1024)
+
+void deep()
+{
+  volatile char buffer[DEEP];       // four times the whole stack of the assignment
+  for (int i = 0; i < DEEP; i++)
+  {
+    buffer[i] = 1;                  // through the volatile lvalue, so the stores are not optimized away
+  }
+  uthread_yield ();
+  uthread_terminate (uthread_get_tid());
+}
+
+void shallow()
+{
+  uthread_yield ();
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  uthread_init (999999);
+  int tid = uthread_spawn (deep);
+  uthread_yield ();                 // deep fills its buffer and yields back
+  int high = uthread_get_stack_high_water (tid);
+  printf ("%d ", high >= DEEP && high < DEEP + SHALLOW_MAX);
+  uthread_yield ();                 // deep terminates, its stack goes back to the pool
+  tid = uthread_spawn (shallow);    // on the same stack, whose pages were given back
+  uthread_yield ();
+  printf ("%d ", uthread_get_stack_high_water (tid) < SHALLOW_MAX);
+  printf ("%d", uthread_get_stack_high_water (0));
+  printf ("\nYou should see: 1 1 -1\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,39 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+uthread_sem_t woken;
+int jobs = 0;
+
+void napper()
+{
+  uthread_sleep (2);
+  uthread_sem_post (&woken);
+  uthread_terminate (uthread_get_tid ());
+}
+
+void sampler()
+{
+  while (jobs < 3)
+  {
+    jobs++;
+    uthread_wait_period ();
+  }
+  uthread_sem_post (&woken);
+  uthread_terminate (uthread_get_tid ());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.quantum_usecs = 1000;
+  uthread_init_ex (&config);
+  uthread_sem_init (&woken, 0);
+  uthread_spawn (napper);
+  printf ("%d ", uthread_sem_wait (&woken));   // no thread is ready while the napper sleeps
+  int start = uthread_get_total_quantums ();
+  uthread_spawn_periodic (sampler, 5, 1);
+  printf ("%d ", uthread_sem_wait (&woken));   // nor while the sampler waits for its releases
+  printf ("%d %d", jobs, uthread_get_total_quantums () - start >= 10);
+  printf ("\nYou should see: 0 0 3 1\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,33 @@
+#include "uthreads.h"
+#include "stdio.h"
+#include <signal.h>
+#include <unistd.h>
+
+void g()
+{
+  printf ("%d ", uthread_get_tid());
+  uthread_sleep_until (5);
+  printf ("%d ", uthread_get_tid());
+  uthread_terminate (uthread_get_tid());
+}
+
+void f()
+{
+  printf ("%d ", uthread_get_tid());
+  uthread_sleep_until (uthread_get_total_quantums());
+  printf ("%d ", uthread_get_tid());
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  uthread_init (999999);
+  uthread_spawn (g);
+  uthread_spawn (f);
+  kill(getpid(),SIGVTALRM);
+  printf ("%d ", uthread_get_tid());
+  kill(getpid(),SIGVTALRM);
+  kill(getpid(),SIGVTALRM);
+  printf ("\nYou should see: 1 2 0 2 1\n");
+  uthread_terminate(0);
+}
@@ -0,0 +1,26 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+#define THREADS 20000
+
+void f()
+{
+  while (1) {}
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {999999, THREADS};
+  uthread_init_ex (&config);
+  for (int i = 1; i < THREADS; i++)
+  {
+    uthread_spawn (f);
+  }
+  uthread_terminate (17000);
+  uthread_terminate (5);
+  printf ("%d ", uthread_spawn (f));
+  printf ("%d ", uthread_spawn (f));
+  printf ("%d ", uthread_spawn (f));
+  printf ("\nYou should see: 5 17000 -1\n");
+  uthread_terminate(0);
+}
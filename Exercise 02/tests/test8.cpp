@@ -0,0 +1,29 @@
+#include "uthreads.h"
+#include "stdio.h"
+#include <signal.h>
+#include <unistd.h>
+
+#define BIG_STACK (64 * 1024)
+
+void f()
+{
+  volatile char buffer[BIG_STACK / 2]; // would overflow a 4096 bytes stack into its guard page
+  buffer[0] = 0;
+  printf ("%d ", uthread_get_tid() + buffer[0]);
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  uthread_init (999999);
+  printf ("%d ", uthread_spawn_ex (f, -1));
+  for (int i = 0; i < 3; i++)
+  {
+    uthread_spawn_ex (f, BIG_STACK);
+  }
+  kill(getpid(),SIGVTALRM);
+  uthread_spawn_ex (f, BIG_STACK);
+  kill(getpid(),SIGVTALRM);
+  printf ("\nYou should see: -1 1 2 3 1\n");
+  uthread_terminate(0);
+}
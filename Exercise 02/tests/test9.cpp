@@ -0,0 +1,29 @@
+#include "uthreads.h"
+#include "stdio.h"
+
+void f()
+{
+  for (int i = 0; i < 2; i++)
+  {
+    printf ("%d ", uthread_get_tid());
+    uthread_yield ();
+  }
+  uthread_terminate (uthread_get_tid());
+}
+
+int main(int argc, char **argv)
+{
+  struct uthread_config config = {};
+  config.cooperative = 1;
+  uthread_init_ex (&config);
+  uthread_spawn (f);
+  uthread_spawn (f);
+  while (uthread_get_total_quantums() < 7)
+  {
+    printf ("%d ", uthread_get_tid());
+    uthread_yield ();
+  }
+  printf ("%d ", uthread_get_total_quantums());
+  printf ("\nYou should see: 0 1 2 0 1 2 7\n");
+  uthread_terminate(0);
+}
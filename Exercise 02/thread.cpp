@@ -1,76 +1,28 @@
 #include "thread.h"
 
-#ifdef __x86_64__
-
-address_t translateAddress(address_t addr) {
-    address_t ret;
-    asm volatile("xor    %%fs:0x30,%0\n"
-                 "rol    $0x11,%0\n"
-            : "=g" (ret)
-            : "0" (addr));
-    return ret;
-}
-
-#else
-address_t translateAddress(address_t addr) {
-    address_t ret;
-    asm volatile("xor    %%gs:0x18,%0\n"
-                 "rol    $0x9,%0\n"
-    : "=g" (ret)
-    : "0" (addr));
-    return ret;
-}
-#endif
-
 /**
  * @brief Constructor for the Thread class.
  * @param id the thread id.
  * @param entryPoint the thread entry point.
+ * @param stack the lowest address of the thread stack, nullptr for a thread that runs on the process stack.
+ * @param stackSize the thread stack size in bytes.
  * @return a new Thread object.
  */
-Thread::Thread(unsigned int id, thread_entry_point entryPoint)
-        : tid(id), stack(new char[STACK_SIZE]), entryPoint(entryPoint),
-          quantumCounter(0), sleepCounter(0), isBlocked(false) {
-    initEnv();
-}
-/**
- * @brief Copy constructor for the Thread class.
- * @param other the Thread object to copy.
- * @return a new Thread object.
- */
-
-Thread::Thread(const Thread &other)
-        : tid(other.tid), stack(new char[STACK_SIZE]), entryPoint(other.entryPoint),
-          quantumCounter(other.quantumCounter), sleepCounter(other.sleepCounter), isBlocked(other.isBlocked) {
-    std::memcpy(stack, other.stack, STACK_SIZE);
-    std::memcpy(&env, &other.env, sizeof(sigjmp_buf));
-}
-
-/**
- * @brief Assignment operator for the Thread class.
- * @param other the Thread object to copy.
- * @return a new Thread object.
- */
-Thread &Thread::operator=(const Thread &other) {
-    if (this != &other) {
-        tid = other.tid;
-        delete[] stack;
-        stack = new char[STACK_SIZE];
-        std::memcpy(stack, other.stack, STACK_SIZE);
-        quantumCounter = other.quantumCounter;
-        entryPoint = other.entryPoint;
-        isBlocked = other.isBlocked;
-        sleepCounter = other.sleepCounter;
-        std::memcpy(&env, &other.env, sizeof(sigjmp_buf));
+Thread::Thread(unsigned int id, thread_entry_point entryPoint, char *stack, size_t stackSize)
+        : tid(id), stack(stack), stackSize(stackSize), quantumCounter(0), entryPoint(entryPoint),
+          isBlocked(false), wakeQuantum(0), sleepIndex(NOT_SLEEPING), ioFd(NO_IO_WAIT), waitQueue(nullptr),
+          waitPrev(nullptr), waitNext(nullptr), state(ThreadState::READY), priority(UTHREAD_DEFAULT_PRIORITY),
+          basePriority(UTHREAD_DEFAULT_PRIORITY), listPrev(nullptr), listNext(nullptr), queuedCount(0),
+          exiting(false) {
+    if (stack != nullptr) {
+        initEnv();
     }
-    return *this;
 }
 
 /**
- * @brief Destructor for the Thread class.
+ * @brief Destructor for the Thread class. The stack is returned to the stack pool by the engine.
  */
 Thread::~Thread() {
-    delete[] stack;
     stack = nullptr;
 }
 
@@ -96,10 +48,31 @@ unsigned int  Thread::getThreadQuantumCounter() const {
 }
 
 /**
- * @return the current thread sleep counter.
+ * @return the total quantum the current thread wakes up at.
  */
-unsigned int Thread::getThreadSleepCounter() const {
-    return this->sleepCounter;
+int Thread::getThreadWakeQuantum() const {
+    return this->wakeQuantum;
+}
+
+/**
+ * @return true if the current thread is in the sleep queue.
+ */
+bool Thread::isSleeping() const {
+    return this->sleepIndex != NOT_SLEEPING;
+}
+
+/**
+ * @return true if the current thread waits on a file descriptor.
+ */
+bool Thread::isWaitingIo() const {
+    return this->ioFd != NO_IO_WAIT;
+}
+
+/**
+ * @return true if the current thread waits on a synchronization object.
+ */
+bool Thread::isWaitingSync() const {
+    return this->waitQueue != nullptr;
 }
 
 /**
@@ -119,22 +92,16 @@ void Thread::setThreadQuantumCounter(unsigned int status)  {
 }
 
 /**
- * @brief set the current thread sleep counter.
- * @param status the new status.
+ * @brief set the total quantum the current thread wakes up at.
+ * @param quantum the new wake up quantum.
  */
-void  Thread::setThreadSleepCounter(unsigned int status)  {
-    this->sleepCounter = status;
+void Thread::setThreadWakeQuantum(int quantum) {
+    this->wakeQuantum = quantum;
 }
 
 /**
- * @brief Initialize the thread environment.
+ * @brief Initialize the thread context to start at threadTrampoline on the thread stack.
  */
 void Thread::initEnv() {
-    auto sp = reinterpret_cast<address_t>(&stack[STACK_SIZE]);
-    auto pc = reinterpret_cast<address_t>(entryPoint);
-
-    sigsetjmp(env, 1);
-    env->__jmpbuf[JB_SP] = translateAddress(sp);
-    env->__jmpbuf[JB_PC] = translateAddress(pc);
-    sigemptyset(&env->__saved_mask);
+    contextInit(context, stack, stackSize, &threadTrampoline);
 }
@@ -2,23 +2,29 @@
 #define THREAD_H
 
 #include "uthreads.h"
+#include "context.h"
 #include <csignal>
-#include <csetjmp>
 #include <cstring>
 
-#ifdef __x86_64__
-/* code for 64 bit Intel arch */
-typedef unsigned long address_t;
-#define JB_SP 6
-#define JB_PC 7
-#else
-/* code for 32 bit Intel arch */
-typedef unsigned int address_t;
-#define JB_SP 4
-#define JB_PC 5
-#endif
+#define NOT_SLEEPING (-1) /* the sleepIndex of a thread that is not in the sleep queue */
 
-address_t translateAddress(address_t addr);
+#define NO_IO_WAIT (-1) /* the ioFd of a thread that is not waiting for I/O */
+
+/**
+ * @brief The function every spawned thread starts running at, on its own stack. It runs the thread's entry point and
+ * terminates the thread if the entry point returns.
+ */
+void threadTrampoline();
+
+/**
+ * @brief The ThreadState enum represents the scheduling state of a thread, which tells the container it is in.
+ */
+enum class ThreadState {
+    RUNNING,   // the runningThread of a worker, in no container.
+    READY,     // in the ready queue of its priority or a ready heap, or in a worker's ready deque with M:N workers.
+    BLOCKED,   // in the blocked list, because it is blocked, sleeping, waiting for I/O or in a wait queue, or several.
+    TERMINATED // terminated with M:N workers while still queued, freed when its last deque entry is taken.
+};
 
 /**
  * @brief The Thread class.
@@ -27,34 +33,67 @@ class Thread {
 
 public:
     unsigned int tid;
-    char *stack;
-    sigjmp_buf env{};
+    char *stack; // the lowest address of the stack, owned by the engine's stack pool. nullptr for the main thread.
+    size_t stackSize;
+    Context context{};
     unsigned int quantumCounter;
     thread_entry_point entryPoint;
     bool isBlocked;
-    unsigned int sleepCounter;
+    int wakeQuantum;
+    int sleepIndex;
+    int ioFd; // the file descriptor the thread waits on in the engine's I/O poller.
+    uthread_wait_queue *waitQueue; // the queue of the synchronization object the thread waits on, nullptr if none.
+    Thread *waitPrev;
+    Thread *waitNext;
+    ThreadState state;
+    int priority;
+    int basePriority; // the priority set by the user, the highest one MLFQ boosts the thread back to.
+    Thread *listPrev; // the neighbours in the ready queue or the blocked list the thread is in, or its siblings in
+    Thread *listNext; // the fair ready heap.
+    Thread *fairChild = nullptr; // its first child in the fair ready heap.
+    unsigned long fairOrder = 0; // when it was pushed to the fair ready heap, for the ties between equal vruntimes.
+    long vruntime = 0; // its run time weighted by its priority, under UTHREAD_POLICY_FAIR.
+    long chargedUntilNsec = 0; // the end of the last run time added to its vruntime, while RUNNING.
+    int period = 0;     // the quantums between the releases of a periodic thread, 0 for a thread that is not periodic.
+    int budget = 0;     // the quantums a periodic thread may run each period.
+    int budgetLeft = 0; // the quantums it may still start in its current period.
+    long deadline = 0;  // the quantum its current period ends at, which is its next release.
+    bool jobDone = false; // it waited for its next release in its current period.
+    int queuedCount; // the number of its entries in the workers' ready deques, some may be stale.
+    bool exiting;    // terminated while running on another worker, it terminates at its next switch.
+    struct uthread_stats stats{}; // its scheduling statistics, without its current run or ready wait.
+    long runSinceNsec = 0;   // when its current run started, while RUNNING.
+    long readySinceNsec = 0; // when it last became READY, 0 once it runs.
 
     /**
      * @brief Constructor for the Thread class.
      * @param id the thread id.
      * @param entryPoint the thread entry point.
+     * @param stack the lowest address of the thread stack, nullptr for a thread that runs on the process stack.
+     * @param stackSize the thread stack size in bytes.
      * @return a new Thread object.
      */
-    Thread(unsigned int id, thread_entry_point entryPoint);
+    Thread(unsigned int id, thread_entry_point entryPoint, char *stack, size_t stackSize);
 
     /**
-     * @brief Copy constructor for the Thread class.
-     * @param other the Thread object to copy.
-     * @return a new Thread object.
+     * @brief Threads are not copyable, as the saved context points into the thread's own stack.
      */
-    Thread(const Thread &other);
+    Thread(const Thread &other) = delete;
 
     /**
-     * @brief Assignment operator for the Thread class.
-     * @param other the Thread object to copy.
-     * @return a new Thread object.
+     * @brief Threads are not copyable, as the saved context points into the thread's own stack.
+     */
+    Thread &operator=(const Thread &other) = delete;
+
+    /**
+     * @brief Threads are not movable either, as the lists and queues they are in link them by address.
+     */
+    Thread(Thread &&other) = delete;
+
+    /**
+     * @brief Threads are not movable either, as the lists and queues they are in link them by address.
      */
-    Thread &operator=(const Thread &other);
+    Thread &operator=(Thread &&other) = delete;
 
     /**
      * @brief Destructor for the Thread class.
@@ -80,10 +119,28 @@ public:
     unsigned int getThreadQuantumCounter() const;
 
     /**
-     * @brief Get the thread stack.
-     * @return the thread stack.
+     * @brief Get the total quantum the thread wakes up at.
+     * @return the wake up quantum.
+     */
+    int getThreadWakeQuantum() const;
+
+    /**
+     * @brief Checks if the thread is in the sleep queue.
+     * @return true if the thread is sleeping.
+     */
+    bool isSleeping() const;
+
+    /**
+     * @brief Checks if the thread waits on a file descriptor.
+     * @return true if the thread is waiting for I/O.
      */
-    unsigned int getThreadSleepCounter() const;
+    bool isWaitingIo() const;
+
+    /**
+     * @brief Checks if the thread waits on a synchronization object.
+     * @return true if the thread is in a wait queue.
+     */
+    bool isWaitingSync() const;
 
     /**
      * @brief Set the thread stack.
@@ -98,14 +155,14 @@ public:
     void setThreadQuantumCounter(unsigned int status);
 
     /**
-     * @brief Set the thread stack.
-     * @param status the new thread stack.
+     * @brief Set the total quantum the thread wakes up at.
+     * @param quantum the new wake up quantum.
      */
-    void setThreadSleepCounter(unsigned int status);
+    void setThreadWakeQuantum(int quantum);
 
 private:
     /**
-     * @brief Initialize the thread environment.
+     * @brief Initialize the thread context to start at threadTrampoline on the thread stack.
      */
     void initEnv();
 };
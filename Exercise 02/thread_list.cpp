@@ -0,0 +1,63 @@
+#include "thread_list.h"
+#include "thread.h"
+
+/**
+ * @brief Appends a thread.
+ * @param thread a thread that is in no list.
+ */
+void ThreadList::pushBack(Thread *thread) {
+    thread->listPrev = tail;
+    thread->listNext = nullptr;
+    if (tail != nullptr) {
+        tail->listNext = thread;
+    } else {
+        head = thread;
+    }
+    tail = thread;
+}
+
+/**
+ * @brief Removes a thread from the list.
+ * @param thread a thread in the list.
+ */
+void ThreadList::remove(Thread *thread) {
+    if (thread->listPrev != nullptr) {
+        thread->listPrev->listNext = thread->listNext;
+    } else {
+        head = thread->listNext;
+    }
+    if (thread->listNext != nullptr) {
+        thread->listNext->listPrev = thread->listPrev;
+    } else {
+        tail = thread->listPrev;
+    }
+    thread->listPrev = thread->listNext = nullptr;
+}
+
+/**
+ * @brief Get the first thread.
+ * @return the thread, the list must not be empty.
+ */
+Thread *ThreadList::front() const {
+    return head;
+}
+
+/**
+ * @brief Checks if the list is empty.
+ * @return true if the list has no thread.
+ */
+bool ThreadList::empty() const {
+    return head == nullptr;
+}
+
+/**
+ * @brief Removes all the threads.
+ */
+void ThreadList::clear() {
+    for (Thread *thread = head; thread != nullptr;) {
+        Thread *next = thread->listNext;
+        thread->listPrev = thread->listNext = nullptr;
+        thread = next;
+    }
+    head = tail = nullptr;
+}
@@ -0,0 +1,47 @@
+#ifndef THREAD_LIST_H
+#define THREAD_LIST_H
+
+class Thread;
+
+/**
+ * @brief The ThreadList class is a FIFO list of threads, used for the ready queues and the blocked threads. The list
+ * is intrusive, linked through the listPrev and listNext of the threads, so linking and unlinking allocate nothing
+ * and take O(1). A thread is in at most one list, the one its state says.
+ */
+class ThreadList {
+public:
+    /**
+     * @brief Appends a thread.
+     * @param thread a thread that is in no list.
+     */
+    void pushBack(Thread *thread);
+
+    /**
+     * @brief Removes a thread from the list.
+     * @param thread a thread in the list.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * @brief Get the first thread.
+     * @return the thread, the list must not be empty.
+     */
+    Thread *front() const;
+
+    /**
+     * @brief Checks if the list is empty.
+     * @return true if the list has no thread.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Removes all the threads.
+     */
+    void clear();
+
+private:
+    Thread *head = nullptr;
+    Thread *tail = nullptr;
+};
+
+#endif // THREAD_LIST_H
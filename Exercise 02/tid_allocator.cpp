@@ -0,0 +1,62 @@
+#include "tid_allocator.h"
+
+#define BITS_PER_WORD 64
+
+/**
+ * @brief Constructor for the TidAllocator class, with every id free.
+ * @param capacity the number of ids, 0 to capacity - 1.
+ */
+TidAllocator::TidAllocator(int capacity) {
+    size_t bits = capacity;
+    do {
+        std::vector<uint64_t> level((bits + BITS_PER_WORD - 1) / BITS_PER_WORD, ~0ull);
+        if (bits % BITS_PER_WORD != 0) { // the bits past the capacity are never free.
+            level.back() = (1ull << (bits % BITS_PER_WORD)) - 1;
+        }
+        bits = level.size();
+        levels.push_back(level);
+    } while (bits > 1);
+}
+
+/**
+ * @brief Takes the lowest free id.
+ * @return the id, or -1 if all the ids are taken.
+ */
+int TidAllocator::acquire() {
+    if (levels.back()[0] == 0) {
+        return -1;
+    }
+    size_t index = 0;
+    for (size_t level = levels.size(); level-- > 0;) {
+        index = index * BITS_PER_WORD + __builtin_ctzll(levels[level][index]);
+    }
+    update(static_cast<int>(index), false);
+    return static_cast<int>(index);
+}
+
+/**
+ * @brief Frees a taken id.
+ * @param tid the id.
+ */
+void TidAllocator::release(int tid) {
+    update(tid, true);
+}
+
+/**
+ * @brief Sets or clears the bit of an id, and propagates the change of its word to the levels above.
+ * @param tid the id.
+ * @param free true to mark the id free, false to mark it taken.
+ */
+void TidAllocator::update(int tid, bool free) {
+    size_t index = tid;
+    for (auto &level: levels) {
+        uint64_t &word = level[index / BITS_PER_WORD];
+        bool hadFree = word != 0;
+        uint64_t bit = 1ull << (index % BITS_PER_WORD);
+        word = free ? (word | bit) : (word & ~bit);
+        if ((word != 0) == hadFree) { // the levels above don't change.
+            return;
+        }
+        index /= BITS_PER_WORD;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef TID_ALLOCATOR_H
+#define TID_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The TidAllocator class hands out the lowest free thread id.
+ * The free ids are kept in a hierarchical bitmap: a set bit in the bottom level marks a free id, and a set bit in
+ * every level above marks a word below it that still has a free id. Finding the lowest free id is a find-first-set
+ * per level, so acquiring and releasing an id take O(log64 capacity) regardless of how many ids are taken.
+ */
+class TidAllocator {
+public:
+    /**
+     * @brief Constructor for the TidAllocator class, with every id free.
+     * @param capacity the number of ids, 0 to capacity - 1.
+     */
+    explicit TidAllocator(int capacity);
+
+    /**
+     * @brief Takes the lowest free id.
+     * @return the id, or -1 if all the ids are taken.
+     */
+    int acquire();
+
+    /**
+     * @brief Frees a taken id.
+     * @param tid the id.
+     */
+    void release(int tid);
+
+private:
+    std::vector<std::vector<uint64_t>> levels; // levels[0] holds a bit per id, the last level is a single word.
+
+    /**
+     * @brief Sets or clears the bit of an id, and propagates the change of its word to the levels above.
+     * @param tid the id.
+     * @param free true to mark the id free, false to mark it taken.
+     */
+    void update(int tid, bool free);
+};
+
+#endif // TID_ALLOCATOR_H
@@ -0,0 +1,132 @@
+/*
+ * Converts a scheduling trace written by uthread_trace_dump to the Chrome trace event JSON format, which
+ * chrome://tracing and ui.perfetto.dev open. Every worker is a track: the runs of the threads are slices named after
+ * the thread, ending with the reason it was switched out, and the other events are instants on the track.
+ * Usage: ./trace_to_chrome trace_file [json_file], the JSON goes to stdout without a json_file.
+ */
+#include "../trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static const char *const reasonNames[] = {"CYCLE", "BLOCKED", "TERMINATE"};
+
+/**
+ * @brief Reads a trace file.
+ * @param path the path of the file.
+ * @param header receives the header.
+ * @param events receives the events.
+ * @return true on success.
+ */
+static bool readTrace(const char *path, TraceFileHeader &header, std::vector<TraceEvent> &events) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, TRACE_MAGIC,
+                                                                         sizeof(TRACE_MAGIC)) == 0 &&
+                 header.version == TRACE_VERSION;
+    if (valid) {
+        events.resize(header.eventCount);
+        valid = fread(events.data(), sizeof(TraceEvent), events.size(), file) == events.size();
+    }
+    fclose(file);
+    return valid;
+}
+
+/**
+ * @brief Writes an instant event.
+ * @param out the JSON output.
+ * @param name the event name.
+ * @param ts the time stamp in microseconds.
+ * @param event the event.
+ * @param argName the name of the event argument, nullptr for none.
+ */
+static void writeInstant(FILE *out, const char *name, double ts, const TraceEvent &event, const char *argName) {
+    fprintf(out, ",\n{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 0, \"tid\": %u, "
+                 "\"args\": {\"tid\": %d", name, ts, event.worker, event.tid);
+    if (argName != nullptr) {
+        fprintf(out, ", \"%s\": %d", argName, event.arg);
+    }
+    fprintf(out, "}}");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " trace_file [json_file]" << std::endl;
+        return 1;
+    }
+    TraceFileHeader header{};
+    std::vector<TraceEvent> events;
+    if (!readTrace(argv[1], header, events)) {
+        std::cerr << "Invalid trace file " << argv[1] << std::endl;
+        return 1;
+    }
+    FILE *out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (out == nullptr) {
+        std::cerr << "Failed to open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // The counter ticks per nanosecond, from the two readings of the counter against the monotonic clock.
+    double ticksPerNsec = header.dumpNsec > header.startNsec
+                          ? (double) (header.dumpTsc - header.startTsc) / (double) (header.dumpNsec - header.startNsec)
+                          : 1.0;
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TraceEvent &a, const TraceEvent &b) { return a.tsc < b.tsc; });
+
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"uthreads\"}}");
+    for (uint32_t worker = 0; worker < header.workers; worker++) {
+        fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, "
+                     "\"args\": {\"name\": \"worker %u\"}}", worker, worker);
+    }
+
+    std::vector<int> openSlice(header.workers, -1); // the thread whose run is open on each worker, -1 for none.
+    double lastTs = 0;
+    for (const TraceEvent &event: events) {
+        double ts = (double) (int64_t) (event.tsc - header.startTsc) / ticksPerNsec / 1000;
+        lastTs = std::max(lastTs, ts);
+        if (event.worker >= header.workers) {
+            continue;
+        }
+        switch (event.type) {
+            case TRACE_SWITCH_IN:
+                fprintf(out, ",\n{\"name\": \"thread %d\", \"ph\": \"B\", \"ts\": %.3f, \"pid\": 0, \"tid\": %u}",
+                        event.tid, ts, event.worker);
+                openSlice[event.worker] = event.tid;
+                break;
+            case TRACE_SWITCH_OUT:
+                if (openSlice[event.worker] == -1) { // the run started before the oldest event kept.
+                    break;
+                }
+                fprintf(out, ",\n{\"ph\": \"E\", \"ts\": %.3f, \"pid\": 0, \"tid\": %u, \"args\": {\"reason\": \"%s\"}}",
+                        ts, event.worker, event.arg >= 0 && event.arg <= TRACE_TERMINATE ? reasonNames[event.arg] : "?");
+                openSlice[event.worker] = -1;
+                break;
+            case TRACE_SPAWN:
+                writeInstant(out, "spawn", ts, event, "priority");
+                break;
+            case TRACE_SLEEP:
+                writeInstant(out, "sleep", ts, event, "wake_quantum");
+                break;
+            case TRACE_RESUME:
+                writeInstant(out, "resume", ts, event, nullptr);
+                break;
+            case TRACE_TIMER:
+                writeInstant(out, "timer", ts, event, "deferred");
+                break;
+            default:
+                break;
+        }
+    }
+    for (uint32_t worker = 0; worker < header.workers; worker++) { // the runs still going on at the dump.
+        if (openSlice[worker] != -1) {
+            fprintf(out, ",\n{\"ph\": \"E\", \"ts\": %.3f, \"pid\": 0, \"tid\": %u}", lastTs, worker);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return out == stdout || fclose(out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "trace.h"
+
+#include <new>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Reads the time stamp counter, or the monotonic clock in nanoseconds where there is none.
+ * @return the counter.
+ */
+uint64_t readTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Destructor for the TraceBuffer class.
+ */
+TraceBuffer::~TraceBuffer() {
+    delete[] events;
+}
+
+/**
+ * @brief Allocates the buffer.
+ * @param capacity the number of events kept, rounded up to a power of two.
+ * @return true on success.
+ */
+bool TraceBuffer::allocate(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+    events = new(std::nothrow) TraceEvent[rounded];
+    if (events == nullptr) {
+        return false;
+    }
+    mask = rounded - 1;
+    return true;
+}
+
+/**
+ * @brief Records an event, overwriting the oldest one once the buffer is full.
+ * @param type the TraceEventType.
+ * @param worker the worker index.
+ * @param tid the thread the event is about.
+ * @param arg depends on the type.
+ */
+void TraceBuffer::record(uint16_t type, uint16_t worker, int32_t tid, int32_t arg) {
+    uint64_t index = __atomic_fetch_add(&next, 1, __ATOMIC_RELAXED);
+    TraceEvent &event = events[index & mask];
+    event.tsc = readTsc();
+    event.tid = tid;
+    event.arg = arg;
+    event.type = type;
+    event.worker = worker;
+    event.unused = 0;
+}
+
+/**
+ * @brief Get the number of events kept.
+ * @return the number of events.
+ */
+size_t TraceBuffer::size() const {
+    return events == nullptr ? 0 : (size_t) (next < mask + 1 ? next : mask + 1);
+}
+
+/**
+ * @brief Writes the events kept, oldest first.
+ * @param file the file.
+ * @return true on success.
+ */
+bool TraceBuffer::write(FILE *file) const {
+    size_t count = size();
+    uint64_t first = next - count;
+    for (uint64_t i = first; i < first + count; i++) {
+        if (fwrite(&events[i & mask], sizeof(TraceEvent), 1, file) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#define TRACE_MAGIC "UTTRACE" /* the first bytes of a trace file, with the terminating null */
+#define TRACE_VERSION 1
+
+/**
+ * @brief The kinds of scheduling events in a trace.
+ */
+enum TraceEventType : uint16_t {
+    TRACE_SPAWN,      // a thread was created, arg is its priority.
+    TRACE_SWITCH_IN,  // a thread started running on the worker.
+    TRACE_SWITCH_OUT, // a thread stopped running on the worker, arg is the TraceSwitchReason.
+    TRACE_SLEEP,      // a thread went to sleep, arg is the total quantum it wakes up at.
+    TRACE_RESUME,     // a blocked thread was resumed.
+    TRACE_TIMER       // the worker's timer fired during a thread (tid -1 if idle), arg is 1 if it was deferred.
+};
+
+/**
+ * @brief Why a thread was switched out, the arg of a TRACE_SWITCH_OUT event.
+ */
+enum TraceSwitchReason : int32_t {
+    TRACE_CYCLE,
+    TRACE_BLOCKED,
+    TRACE_TERMINATE
+};
+
+/**
+ * @brief A scheduling event, as it is kept in a worker's ring buffer and written to a trace file.
+ */
+struct TraceEvent {
+    uint64_t tsc;    // the time stamp counter when the event happened.
+    int32_t tid;     // the thread the event is about.
+    int32_t arg;     // depends on the type.
+    uint16_t type;   // a TraceEventType.
+    uint16_t worker; // the worker the event happened on.
+    uint32_t unused;
+};
+
+/**
+ * @brief The start of a trace file, followed by eventCount TraceEvents, each worker's in the order they happened.
+ * Two readings of the time stamp counter against the monotonic clock convert its ticks to time.
+ */
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t workers;
+    uint64_t startTsc;   // the counter when tracing started,
+    int64_t startNsec;   // and the monotonic clock then.
+    uint64_t dumpTsc;    // the counter when the trace was written,
+    int64_t dumpNsec;    // and the monotonic clock then.
+    uint64_t eventCount;
+};
+
+/**
+ * @brief Reads the time stamp counter, or the monotonic clock in nanoseconds where there is none.
+ * @return the counter.
+ */
+uint64_t readTsc();
+
+/**
+ * @brief The TraceBuffer class is the ring buffer of the last scheduling events of a worker. Events are recorded by
+ * the worker's kernel thread alone, from the engine and from the timer handler, which may interrupt a recording, so
+ * a slot is claimed with an atomic increment.
+ */
+class TraceBuffer {
+public:
+    /**
+     * @brief Constructor for the TraceBuffer class, with no capacity until it is allocated.
+     */
+    TraceBuffer() = default;
+
+    /**
+     * @brief Trace buffers are not copyable, they own their events.
+     */
+    TraceBuffer(const TraceBuffer &other) = delete;
+
+    /**
+     * @brief Trace buffers are not copyable, they own their events.
+     */
+    TraceBuffer &operator=(const TraceBuffer &other) = delete;
+
+    /**
+     * @brief Destructor for the TraceBuffer class.
+     */
+    ~TraceBuffer();
+
+    /**
+     * @brief Allocates the buffer.
+     * @param capacity the number of events kept, rounded up to a power of two.
+     * @return true on success.
+     */
+    bool allocate(size_t capacity);
+
+    /**
+     * @brief Records an event, overwriting the oldest one once the buffer is full.
+     * @param type the TraceEventType.
+     * @param worker the worker index.
+     * @param tid the thread the event is about.
+     * @param arg depends on the type.
+     */
+    void record(uint16_t type, uint16_t worker, int32_t tid, int32_t arg);
+
+    /**
+     * @brief Get the number of events kept.
+     * @return the number of events.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Writes the events kept, oldest first.
+     * @param file the file.
+     * @return true on success.
+     */
+    bool write(FILE *file) const;
+
+private:
+    TraceEvent *events = nullptr;
+    uint64_t mask = 0; // the capacity - 1.
+    uint64_t next = 0; // the number of events ever recorded.
+};
+
+#endif // TRACE_H
@@ -1,15 +1,31 @@
 #include "uthreads.h"
 #include "thread.h"
-
+#include "sleep_queue.h"
+#include "tid_allocator.h"
+#include "stack_pool.h"
+#include "work_stealing_deque.h"
+#include "io_poller.h"
+#include "wait_queue.h"
+#include "thread_list.h"
+#include "fair_queue.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
-#include <list>
-#include <queue>
-#include <unordered_set>
+#include <new>
+#include <vector>
 #include <csignal>
-#include <sys/time.h>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 
 // Constants:
-#define TIMER_ERR "system error: set-itimer had failed. "
+#define TIMER_ERR "system error: timer_settime had failed. "
 
 #define INVALID_ENTRY_POINT_ERR "thread library error: Null entry point. "
 
@@ -21,6 +37,8 @@
 
 #define INVALID_QUANTUM_ERR "thread library error: invalid sleep quantum's. "
 
+#define INVALID_WAKE_QUANTUM_ERR "thread library error: the wake up quantum has already passed. "
+
 #define INVALID_SLEEP_REQUEST_TO_MAIN_THREAD_ERR "thread library error: cannot do sleep to main thread. "
 
 #define INVALID_TID_ERR "thread library error: invalid thread id. "
@@ -29,20 +47,99 @@
 
 #define INVALID_QUANTUM_FOR_INIT_ERR "thread library error: quantum_usecs must not be negative. "
 
-#define SIGACTTION_ERR "system error: sigaction failed for SIGVTALRM signal. "
+#define INVALID_CONFIG_ERR "thread library error: invalid configuration. "
 
-#define SIGPROCMASK_ERR "system error: sigprocmask error. "
+#define INVALID_MAX_THREADS_ERR "thread library error: max_threads must not be negative. "
 
-#define EMPTY_READY_Q_ERR "thread library error: no more threads are available to run. "
+#define INVALID_STACK_SIZE_ERR "thread library error: stack size must not be negative. "
+
+#define MAIN_STACK_ERR "thread library error: the main thread runs on the process stack, which is not measured. "
+
+#define INVALID_PRIORITY_ERR "thread library error: invalid priority. "
+
+#define INVALID_POLICY_ERR "thread library error: invalid scheduling policy. "
+
+#define INVALID_WORKERS_ERR "thread library error: invalid number of workers. "
+
+#define POLICY_WITH_WORKERS_ERR "thread library error: several workers only run the round robin policy. "
+
+#define PRIORITY_WITH_WORKERS_ERR "thread library error: priorities need a single worker. "
+
+#define INVALID_PERIOD_ERR "thread library error: invalid period or budget. "
+
+#define PERIODIC_ADMISSION_ERR "thread library error: the periodic threads would need more than the whole cpu. "
+
+#define PERIODIC_WITH_WORKERS_ERR "thread library error: periodic threads need a single worker. "
+
+#define NOT_PERIODIC_ERR "thread library error: the calling thread is not periodic. "
+
+#define WORKER_ERR "system error: worker kernel thread creation has failed. "
+
+#define WORKER_TIMER_ERR "system error: timer_create had failed. "
 
-#define OPEN_SPOT false
+#define IO_BUSY_ERR "thread library error: another thread already waits on this file descriptor. "
 
-#define TAKEN_SPOT true
+#define EPOLL_ERR "system error: epoll had failed. "
+
+#define INVALID_SYNC_OBJECT_ERR "thread library error: null synchronization object. "
+
+#define MUTEX_NOT_LOCKED_ERR "thread library error: the mutex is not locked. "
+
+#define INVALID_SEM_VALUE_ERR "thread library error: invalid semaphore value. "
+
+#define INVALID_CHAN_CAPACITY_ERR "thread library error: channel capacity must be positive. "
+
+#define INVALID_STATS_ERR "thread library error: null statistics. "
+
+#define INVALID_TRACE_EVENTS_ERR "thread library error: trace_events must not be negative. "
+
+#define INVALID_QUANTUM_BOUNDS_ERR "thread library error: invalid adaptive quantum bounds. "
+
+#define TRACE_DISABLED_ERR "thread library error: the library was initialized without a trace. "
+
+#define TRACE_FILE_ERR "thread library error: the trace file could not be written. "
+
+#define SIGACTTION_ERR "system error: sigaction failed for SIGVTALRM signal. "
+
+#define EMPTY_READY_Q_ERR "thread library error: no more threads are available to run. "
 
 #define SUCCESS_EXIT 0
 
 #define FAILURE_EXIT (-1)
 
+#define MLFQ_BOOST_PERIOD 100 /* quantums between two resets of every thread to its base priority */
+
+#define ADAPTIVE_RATE_ONE 1024 /* the fixed point 1 of the rate of switches out before the quantum expires */
+
+#define ADAPTIVE_RATE_WEIGHT 8 /* the rate moves 1/8 of the way towards every new switch out */
+
+#define ADAPTIVE_MAX_GROWTH 4 /* how many times quantum_usecs the quantum grows to when no thread is preempted */
+
+#define UTILIZATION_EPSILON 1e-9 /* the rounding the sum of the periodic utilizations may exceed 1 by */
+
+#define FAIR_WEIGHT_UNIT 1024 /* the weight of the default priority, whose vruntime advances in real time */
+
+#define FAIR_SLEEPER_CREDIT_NSEC 3000000L /* how far behind the least vruntime a woken thread may come back */
+
+/**
+ * @brief The weight of every priority under UTHREAD_POLICY_FAIR, each one gets 1.25 times the cpu share of the next
+ * one, like the nice levels 0 to 7 of the Linux CFS.
+ */
+static const long fairWeights[UTHREAD_PRIORITY_LEVELS] = {1024, 820, 655, 526, 423, 335, 272, 215};
+
+#define IDLE_SPIN_ROUNDS 64 /* rounds an idle worker yields its cpu for before it starts sleeping between rounds */
+
+#define IDLE_SLEEP_NSEC 50000 /* the sleep between two rounds of a worker that has been idle for long */
+
+#define ALL_THREADS (-1) /* the tid uthread_get_stats sums the statistics of every thread for */
+
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED 1
+#define MUTEX_CONTENDED 2 /* locked, and threads may be waiting, so unlocking goes through the engine */
+
+#define SEM_WAITERS 1 /* the bit of a semaphore value set while threads are waiting */
+#define SEM_UNIT 2 /* a unit of a semaphore value, above the SEM_WAITERS bit */
+
 /**
  * @brief The ThreadAction enum represents the possible actions that can be taken by the thread manager.
  */
@@ -57,6 +154,150 @@ enum class ThreadAction {
  */
 void timerHandler(int sig);
 
+/**
+ * @brief The function the idle context of the first worker starts running at.
+ */
+void idleTrampoline();
+
+/**
+ * @brief The function the kernel threads of the other workers start running at.
+ * @param arg the worker.
+ * @return never returns.
+ */
+void *workerMain(void *arg);
+
+/**
+ * @brief The Worker struct represents a kernel thread running user threads. There is a single one unless the
+ * library is initialized with several workers, for M:N scheduling.
+ */
+struct Worker {
+    int index;
+    pthread_t kernelThread{};
+    Thread *runningThread = nullptr; // nullptr while the worker is idle.
+    Thread *zombie = nullptr; // a thread that terminated itself, freed by finishSwitch once off its stack.
+    WorkStealingDeque readyDeque; // the threads this worker made ready, with several workers.
+    Context idleContext{}; // where the worker looks for ready threads when it has none.
+    timer_t timer{}; // the worker's own preemption timer.
+    clockid_t clock{}; // the clock the timer runs on, the worker's cpu time or the wall clock.
+    bool tickless = false; // the timer is disarmed, the running thread has nothing to share the worker with.
+    long ticklessSinceNsec = 0; // the clock at the start of the running thread's quantum, while tickless.
+    long switchStartNsec = 0; // when the switch the worker is making was decided.
+    long quantumNsec = 0; // the length of the running thread's quantum, which adaptive quantums set every dispatch.
+    TraceBuffer trace; // the last scheduling events on the worker, when tracing.
+
+    /**
+     * @brief Constructs a new Worker object.
+     * @param index the worker index.
+     */
+    explicit Worker(int index) : index(index) {}
+};
+
+static std::atomic_flag engineLock = ATOMIC_FLAG_INIT; // serializes the workers, held across every switch.
+
+static thread_local Worker *workerOfKernelThread = nullptr;
+
+/**
+ * @brief Gets the worker of the calling kernel thread. Not inlined, so the thread local is read again after every
+ * switch, as a user thread may resume on another kernel thread.
+ * @return the current worker.
+ */
+static __attribute__((noinline)) Worker *currentWorker() {
+    return workerOfKernelThread;
+}
+
+// Set while the calling kernel thread runs the engine, where the timer handler must not switch threads.
+static thread_local volatile sig_atomic_t inCriticalSection = 0;
+
+// Set by the timer handler when the quantum expires inside a critical section, so the thread is preempted at its end.
+static thread_local volatile sig_atomic_t preemptionPending = 0;
+
+/**
+ * @brief Enters a critical section of the calling kernel thread, deferring its preemptions to the end of it.
+ * Not inlined, like currentWorker, so the flag of the kernel thread the caller runs on now is the one set.
+ */
+static __attribute__((noinline)) void enterCriticalSection() {
+    inCriticalSection = 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Ends a critical section of the calling kernel thread, unless a preemption was deferred during it, in which
+ * case the section goes on so the caller can run it.
+ * @return true if a preemption is to be run.
+ */
+static __attribute__((noinline)) bool exitCriticalSection() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    inCriticalSection = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    if (!preemptionPending) {
+        return false;
+    }
+    inCriticalSection = 1;
+    preemptionPending = 0;
+    return true;
+}
+
+/**
+ * @brief Takes the engine lock, only used with several workers.
+ */
+static void lockEngine() {
+    while (engineLock.test_and_set(std::memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Takes the engine lock if it is free.
+ * @return true if the lock was taken.
+ */
+static bool tryLockEngine() {
+    return !engineLock.test_and_set(std::memory_order_acquire);
+}
+
+/**
+ * @brief Releases the engine lock, possibly taken by another user thread before the switch to the calling one.
+ */
+static void unlockEngine() {
+    engineLock.clear(std::memory_order_release);
+}
+
+/**
+ * @brief Reads the monotonic clock the statistics are measured on.
+ * @return the clock in nanoseconds.
+ */
+static long monotonicNsec() {
+    struct timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+ * @brief Counts a duration in the power of two bucket of a histogram it falls in.
+ * @param histogram the histogram, of UTHREAD_STATS_BUCKETS buckets.
+ * @param nsec the duration in nanoseconds.
+ */
+static void countInHistogram(long long *histogram, long nsec) {
+    int bucket = nsec > 1 ? 63 - __builtin_clzl((unsigned long) nsec) : 0;
+    histogram[std::min(bucket, UTHREAD_STATS_BUCKETS - 1)]++;
+}
+
+/**
+ * @brief Adds statistics to a sum of statistics.
+ * @param sum the sum.
+ * @param stats the statistics to add.
+ */
+static void addStats(struct uthread_stats &sum, const struct uthread_stats &stats) {
+    sum.run_nsec += stats.run_nsec;
+    sum.ready_nsec += stats.ready_nsec;
+    sum.voluntary_switches += stats.voluntary_switches;
+    sum.involuntary_switches += stats.involuntary_switches;
+    sum.deadline_misses += stats.deadline_misses;
+    for (int i = 0; i < UTHREAD_STATS_BUCKETS; i++) {
+        sum.switch_latency[i] += stats.switch_latency[i];
+        sum.preempt_lateness[i] += stats.preempt_lateness[i];
+    }
+}
+
 /**
  * @brief The ThreadsEngine class represents the thread manager.
  */
@@ -64,86 +305,448 @@ class ThreadsEngine {
 public:
     int totalNumOfQuantumsCount;
     unsigned int quantumUsecs;
-    struct itimerval timer{};
-    Thread *runningThread;
-    std::deque<Thread *> readyQueue;
-    std::unordered_set<Thread *> blockedSet;
-    bool threadTidAvailability[MAX_THREAD_NUM] = {OPEN_SPOT};
+    bool preemptive; // false for cooperative runs, with no timer and no signals.
+    bool wallClock; // quantums are measured in real time instead of in cpu time.
+    bool adaptiveQuantum = false; // every dispatch sizes its quantum, between minQuantumNsec and maxQuantumNsec.
+    long minQuantumNsec = 0;
+    long maxQuantumNsec = 0;
+    int readyCount = 0; // the READY threads.
+    int voluntaryRate = 0; // how often threads are switched out before their quantum expires, of ADAPTIVE_RATE_ONE.
+    std::vector<Worker *> workers;
+    bool multiWorker; // several workers, run under the engine lock.
+    ThreadList readyQueues[UTHREAD_PRIORITY_LEVELS]; // a FIFO queue per priority, 0 is scheduled first.
+    unsigned int readyLevels = 0; // bit p is set when readyQueues[p] is not empty.
+    int policy;
+    int nextBoostQuantum = MLFQ_BOOST_PERIOD;
+    FairQueue deadlineQueue{&Thread::deadline}; // the READY periodic threads by deadline, run before the others.
+    double periodicUtilization = 0; // the sum of the budget / period of the periodic threads.
+    FairQueue fairQueue{&Thread::vruntime}; // the other READY threads by vruntime under UTHREAD_POLICY_FAIR.
+    long minVruntime = 0; // the vruntime of the last thread taken from fairQueue, it never decreases.
+    ThreadList blockedList; // the BLOCKED threads.
+    SleepQueue sleepQueue; // the sleeping threads (also in blockedList), by wake up quantum.
+    IoPoller ioPoller; // the threads waiting for I/O (also in blockedList), by file descriptor.
+    std::vector<Thread *> ioReady; // the threads a poll has woken up, kept to reuse its storage.
+    long ioPolledNsec = 0; // when a switch last polled the threads waiting for I/O.
+    long idleSinceNsec = 0; // when every worker went idle with threads sleeping, with several workers. 0 if not.
+    struct uthread_stats retiredStats{}; // the statistics of the threads that have been freed.
+    bool tracing = false; // every worker records its scheduling events in its trace buffer.
+    uint64_t traceStartTsc = 0; // the time stamp counter when tracing started.
+    long traceStartNsec = 0; // the monotonic clock when tracing started.
+    int maxThreads;
+    std::vector<Thread *> threads; // tid-indexed, nullptr for an available tid. grows up to maxThreads.
+    TidAllocator tidAllocator;
+    StackPool stackPool;
+    size_t defaultStackSize;
 
     /**
      * @brief Constructs a new ThreadsEngine object.
      * @param quantumUsecs the quantum time in microseconds.
+     * @param maxThreads the maximal number of concurrent threads.
+     * @param stackSize the stack size in bytes of threads spawned without one.
+     * @param preemptive whether the running thread is preempted when its quantum expires.
+     * @param wallClock whether quantums are measured in real time instead of in cpu time.
+     * @param policy the scheduling policy, UTHREAD_POLICY_RR, UTHREAD_POLICY_MLFQ or UTHREAD_POLICY_FAIR.
+     * @param workerCount the number of kernel threads running the threads, the calling one included.
      */
-    explicit ThreadsEngine(unsigned int quantumUsecs) : quantumUsecs(quantumUsecs),
-                                                        totalNumOfQuantumsCount(1) {
+    ThreadsEngine(unsigned int quantumUsecs, int maxThreads, size_t stackSize, bool preemptive, bool wallClock,
+                  int policy, int workerCount)
+            : totalNumOfQuantumsCount(1), quantumUsecs(quantumUsecs), preemptive(preemptive), wallClock(wallClock),
+              multiWorker(workerCount > 1), policy(policy), maxThreads(maxThreads), threads(1, nullptr), tidAllocator(maxThreads),
+              defaultStackSize(stackSize) {
+        for (int i = 0; i < workerCount; i++) {
+            workers.push_back(new Worker(i));
+            workers.back()->quantumNsec = (long) quantumUsecs * 1000;
+        }
+        workers[0]->kernelThread = pthread_self();
+        workerOfKernelThread = workers[0];
         auto emptyLambda = []() {}; // just not a nullptr argument for the main thread
-        runningThread = new Thread(0, emptyLambda);
-        runningThread->quantumCounter++;
-        threadTidAvailability[0] = TAKEN_SPOT;
+        Thread *mainThread = new Thread(tidAllocator.acquire(), emptyLambda, nullptr, 0);
+        mainThread->quantumCounter++;
+        mainThread->state = ThreadState::RUNNING;
+        mainThread->runSinceNsec = mainThread->chargedUntilNsec = monotonicNsec();
+        mainThread->stats.quantum_usecs = quantumUsecs;
+        threads[0] = workers[0]->runningThread = mainThread;
     }
 
     /**
      * @brief Constructs a new ThreadsEngine object.
      */
-    ThreadsEngine() : ThreadsEngine(0) {}
+    ThreadsEngine() : ThreadsEngine(0, MAX_THREAD_NUM, STACK_SIZE, true, false, UTHREAD_POLICY_RR, 1) {}
+
+    /**
+     * @brief Gets the thread running on the calling kernel thread.
+     * @return the running thread.
+     */
+    Thread *running() const {
+        return currentWorker()->runningThread;
+    }
 
     /**
      * @brief Destructs the ThreadsEngine object.
      */
     void scheduler() {
+        if (!preemptive) {
+            return;
+        }
         struct sigaction sa{nullptr};
         sa.sa_handler = &timerHandler;
+        // The handler may switch to another thread before it returns, which must not start with the signal blocked.
+        sa.sa_flags = SA_NODEFER;
         if (sigaction(SIGVTALRM, &sa, nullptr) < 0) {
             std::cerr << SIGACTTION_ERR << std::endl;
             exit(1);
         }
-        timer.it_value.tv_sec = quantumUsecs / 1000000;
-        timer.it_value.tv_usec = quantumUsecs % 1000000;
-        timer.it_interval = timer.it_value;
-        restartTheClock();
+        createTimer(workers[0]);
+        startQuantumClock(workers[0]);
+    }
+
+    /**
+     * @brief Starts the kernel threads of the workers other than the calling one, with several workers.
+     */
+    void startWorkers() {
+        if (!multiWorker) {
+            return;
+        }
+        // The first worker's idle loop needs a stack of its own, the others run it on their kernel thread's stack.
+        size_t size = stackPool.roundSize(defaultStackSize);
+        char *stack = stackPool.allocate(size);
+        if (stack == nullptr) {
+            std::cerr << ALLOCATION_FAILURE_ERR << std::endl;
+            exit(1);
+        }
+        contextInit(workers[0]->idleContext, stack, size, &idleTrampoline);
+
+        for (size_t i = 1; i < workers.size(); i++) {
+            pthread_t handle;
+            if (pthread_create(&handle, nullptr, &workerMain, workers[i]) != 0) {
+                std::cerr << WORKER_ERR << std::endl;
+                exit(1);
+            }
+            pthread_detach(handle);
+        }
+    }
+
+    /**
+     * @brief Restarts the clock of a worker.
+     * @param worker the worker.
+     */
+    void restartTheClock(Worker *worker) {
+        if (!preemptive) {
+            return;
+        }
+        worker->tickless = false;
+        struct itimerspec quantum = quantumTimer(worker->quantumNsec, worker->quantumNsec);
+        if (timer_settime(worker->timer, 0, &quantum, nullptr) < 0) {
+            std::cerr << TIMER_ERR << std::endl;
+            exit(1);
+        }
     }
 
     /**
-     * @brief Restarts the clock.
+     * @brief Stops the clock of a worker going idle.
+     * @param worker the worker.
      */
-    void restartTheClock() {
-        if (setitimer(ITIMER_VIRTUAL, &timer, nullptr) < 0) {
+    void stopTheClock(Worker *worker) {
+        if (!preemptive) {
+            return;
+        }
+        worker->tickless = false;
+        struct itimerspec stopped{};
+        if (timer_settime(worker->timer, 0, &stopped, nullptr) < 0) {
             std::cerr << TIMER_ERR << std::endl;
             exit(1);
         }
     }
 
+    /**
+     * @brief Starts the clock of a worker for the quantum its running thread starts, unless the thread has nothing to
+     * share the worker with: no other ready thread, and no sleeping thread or thread waiting for I/O that needs the
+     * quantums to go on. The timer stays disarmed then, and the quantums are counted from the clock when needed.
+     * @param worker the worker.
+     */
+    void startQuantumClock(Worker *worker) {
+        if (!preemptive || quantumUsecs == 0 || hasReady() || !sleepQueue.empty() || ioPoller.hasWaiters() ||
+            worker->runningThread->period != 0) { // a periodic thread is preempted to check its budget.
+            restartTheClock(worker);
+            return;
+        }
+        if (!worker->tickless) {
+            stopTheClock(worker);
+            worker->tickless = true;
+        }
+        worker->ticklessSinceNsec = readClock(worker);
+    }
+
+    /**
+     * @brief Rearms the timers of the tickless workers, once another thread needs the quantums to go on. Each timer
+     * fires at the end of the quantum its running thread is in.
+     */
+    void resumeTicks() {
+        for (Worker *worker: workers) {
+            if (!worker->tickless) {
+                continue;
+            }
+            long left = worker->quantumNsec - countTicklessQuantums(worker);
+            worker->tickless = false;
+            struct itimerspec rest = quantumTimer(left, worker->quantumNsec);
+            if (timer_settime(worker->timer, 0, &rest, nullptr) < 0) {
+                std::cerr << TIMER_ERR << std::endl;
+                exit(1);
+            }
+        }
+    }
+
+    /**
+     * @brief Counts the quantums the running thread of a tickless worker has started since they were last counted.
+     * @param worker the worker.
+     * @return the nanoseconds the thread is into its current quantum, 0 if the worker is not tickless.
+     */
+    long countTicklessQuantums(Worker *worker) {
+        if (!worker->tickless) {
+            return 0;
+        }
+        long quantumNsec = worker->quantumNsec;
+        long elapsed = readClock(worker) - worker->ticklessSinceNsec;
+        long started = elapsed / quantumNsec;
+        if (started > 0) {
+            totalNumOfQuantumsCount += (int) started;
+            Thread *thread = worker->runningThread;
+            thread->setThreadQuantumCounter(thread->getThreadQuantumCounter() + (int) started);
+            worker->ticklessSinceNsec += started * quantumNsec;
+        }
+        return elapsed - started * quantumNsec;
+    }
+
+    /**
+     * @brief Counts the quantums started on every tickless worker, before the quantum counts are read.
+     */
+    void countAllTicklessQuantums() {
+        for (Worker *worker: workers) {
+            countTicklessQuantums(worker);
+        }
+    }
+
+    /**
+     * @brief Gets the setting of a timer that fires at the end of a quantum and then periodically.
+     * @param valueNsec the time to the first expiry.
+     * @param intervalNsec the time between the next expiries.
+     * @return the timer setting.
+     */
+    static struct itimerspec quantumTimer(long valueNsec, long intervalNsec) {
+        struct itimerspec timer{};
+        timer.it_value.tv_sec = valueNsec / 1000000000;
+        timer.it_value.tv_nsec = valueNsec % 1000000000;
+        timer.it_interval.tv_sec = intervalNsec / 1000000000;
+        timer.it_interval.tv_nsec = intervalNsec % 1000000000;
+        return timer;
+    }
+
+    /**
+     * @brief Turns on adaptive quantums, sized by every dispatch between two bounds.
+     * @param minQuantumUsecs the shortest quantum in microseconds, 0 for fixed quantums.
+     * @param maxQuantumUsecs the longest quantum in microseconds, 0 for fixed quantums.
+     */
+    void setQuantumBounds(int minQuantumUsecs, int maxQuantumUsecs) {
+        adaptiveQuantum = preemptive && quantumUsecs != 0 && maxQuantumUsecs != 0;
+        if (!adaptiveQuantum) {
+            return;
+        }
+        minQuantumNsec = (long) minQuantumUsecs * 1000;
+        maxQuantumNsec = (long) maxQuantumUsecs * 1000;
+        for (Worker *worker: workers) {
+            worker->quantumNsec = std::min(std::max(worker->quantumNsec, minQuantumNsec), maxQuantumNsec);
+        }
+        workers[0]->runningThread->stats.quantum_usecs = workers[0]->quantumNsec / 1000;
+    }
+
+    /**
+     * @brief Sizes the quantum a thread starts on a worker, with adaptive quantums. It shrinks with the number of
+     * READY threads per worker, so each waits about quantum_usecs for its turn, and grows up to ADAPTIVE_MAX_GROWTH
+     * times as the threads are more often switched out before their quantum expires, so the few that use their whole
+     * quantum are preempted less often.
+     * @param worker the worker.
+     */
+    void adaptQuantum(Worker *worker) {
+        if (!adaptiveQuantum) {
+            return;
+        }
+        long waiting = std::max(readyCount / (int) workers.size(), 1);
+        long quantum = (long) quantumUsecs * 1000 * (ADAPTIVE_RATE_ONE + (ADAPTIVE_MAX_GROWTH - 1) * voluntaryRate) /
+                       ADAPTIVE_RATE_ONE / waiting;
+        worker->quantumNsec = std::min(std::max(quantum, minQuantumNsec), maxQuantumNsec);
+    }
+
+    /**
+     * @brief Reads the clock of a worker.
+     * @param worker the worker.
+     * @return the clock in nanoseconds.
+     */
+    long readClock(const Worker *worker) const {
+        struct timespec now{};
+        clock_gettime(worker->clock, &now);
+        return now.tv_sec * 1000000000L + now.tv_nsec;
+    }
+
+    /**
+     * @brief Creates the preemption timer of a worker, which measures the cpu time of the calling kernel thread (or
+     * the wall clock) and signals it alone.
+     * @param worker the worker of the calling kernel thread.
+     */
+    void createTimer(Worker *worker) {
+        if (!preemptive) {
+            return;
+        }
+        worker->clock = CLOCK_MONOTONIC;
+        if (!wallClock && pthread_getcpuclockid(pthread_self(), &worker->clock) != 0) {
+            std::cerr << WORKER_TIMER_ERR << std::endl;
+            exit(1);
+        }
+        struct sigevent event{};
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGVTALRM;
+        event._sigev_un._tid = gettid(); // sigev_notify_thread_id, which older glibc headers do not define.
+        if (timer_create(worker->clock, &event, &worker->timer) < 0) {
+            std::cerr << WORKER_TIMER_ERR << std::endl;
+            exit(1);
+        }
+    }
+
+    /**
+     * @brief Allocates the trace buffer of every worker, and starts recording the scheduling events.
+     * @param capacity the number of events each worker keeps, 0 for no trace.
+     */
+    void startTrace(int capacity) {
+        if (capacity == 0) {
+            return;
+        }
+        for (Worker *worker: workers) {
+            if (!worker->trace.allocate((size_t) capacity)) {
+                std::cerr << ALLOCATION_FAILURE_ERR << std::endl;
+                exit(1);
+            }
+        }
+        traceStartTsc = readTsc();
+        traceStartNsec = monotonicNsec();
+        tracing = true;
+    }
+
+    /**
+     * @brief Records a scheduling event in the trace buffer of a worker, when tracing.
+     * @param worker the worker the event happens on.
+     * @param type the TraceEventType.
+     * @param tid the thread the event is about.
+     * @param arg depends on the type.
+     */
+    void traceEvent(Worker *worker, uint16_t type, int tid, int arg) {
+        if (tracing) {
+            worker->trace.record(type, (uint16_t) worker->index, tid, arg);
+        }
+    }
+
+    /**
+     * @brief Writes the trace buffers of the workers to a file.
+     * @param path the path of the file.
+     * @return 0 on success and -1 otherwise.
+     */
+    int dumpTrace(const char *path) {
+        if (!tracing) {
+            std::cerr << TRACE_DISABLED_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        FILE *file = path != nullptr ? fopen(path, "wb") : nullptr;
+        if (file == nullptr) {
+            std::cerr << TRACE_FILE_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        TraceFileHeader header{};
+        memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        header.version = TRACE_VERSION;
+        header.workers = (uint32_t) workers.size();
+        header.startTsc = traceStartTsc;
+        header.startNsec = traceStartNsec;
+        header.dumpTsc = readTsc();
+        header.dumpNsec = monotonicNsec();
+        for (Worker *worker: workers) {
+            header.eventCount += worker->trace.size();
+        }
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (Worker *worker: workers) {
+            written = written && worker->trace.write(file);
+        }
+        if (fclose(file) != 0 || !written) {
+            std::cerr << TRACE_FILE_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        return SUCCESS_EXIT;
+    }
+
     /**
      * @brief Creates a new thread.
      * @param entryPoint the entry point of the thread.
+     * @param stackSize the stack size in bytes, 0 for the default one.
+     * @param priority the priority of the thread.
+     * @param period the quantums between the releases of a periodic thread, 0 for a thread that is not periodic.
+     * @param budget the quantums a periodic thread may run each period.
      * @return the thread id.
      */
-    int createThread(thread_entry_point entryPoint) {
+    int createThread(thread_entry_point entryPoint, int stackSize, int priority, int period = 0, int budget = 0) {
         if (!entryPoint) {
             std::cerr << INVALID_ENTRY_POINT_ERR << std::endl;
             return FAILURE_EXIT;
         }
+        if (stackSize < 0) {
+            std::cerr << INVALID_STACK_SIZE_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (!isValidPriority(priority)) {
+            std::cerr << INVALID_PRIORITY_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (multiWorker && priority != UTHREAD_DEFAULT_PRIORITY) {
+            std::cerr << PRIORITY_WITH_WORKERS_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
 
-        int tid = getNextAvailableTid();
+        int tid = tidAllocator.acquire();
         if (tid == -1) {
             std::cerr << MAX_THREADS_ERR << std::endl;
             return FAILURE_EXIT;
         }
 
-        threadTidAvailability[tid] = TAKEN_SPOT; // Mark the TID as taken
-
         // Create the new thread and handle potential allocation failure
+        size_t size = stackPool.roundSize(stackSize != 0 ? stackSize : defaultStackSize);
+        char *stack = stackPool.allocate(size);
         Thread *newThread = nullptr;
         try {
-            newThread = new Thread(tid, entryPoint);
+            if (stack == nullptr) {
+                throw std::bad_alloc();
+            }
+            if (tid >= (int) threads.size()) {
+                threads.resize(std::min(std::max(2 * threads.size(), (size_t) tid + 1), (size_t) maxThreads));
+            }
+            newThread = new Thread(tid, entryPoint, stack, size);
         } catch (const std::bad_alloc &) {
-            threadTidAvailability[tid] = OPEN_SPOT; // Roll back TID spot as available
+            if (stack != nullptr) {
+                stackPool.release(stack, size);
+            }
+            tidAllocator.release(tid);
             std::cerr << ALLOCATION_FAILURE_ERR << std::endl;
             return FAILURE_EXIT;
         }
 
-        // Add the new thread to the readyQueue
-        readyQueue.push_back(newThread);
+        threads[tid] = newThread; // Mark the TID as taken
+        newThread->priority = newThread->basePriority = priority;
+        newThread->vruntime = minVruntime; // it starts level with the threads that are running now.
+        if (period != 0) { // released at the next quantum, its deadline is its second release.
+            newThread->period = period;
+            newThread->budget = budget;
+            newThread->budgetLeft = budget;
+            newThread->deadline = totalNumOfQuantumsCount + 1 + period;
+            periodicUtilization += (double) budget / period;
+        }
+        traceEvent(currentWorker(), TRACE_SPAWN, tid, priority);
+        pushReady(newThread);
+        preemptIfOutranked();
         return tid;
     }
 
@@ -166,12 +769,19 @@ public:
             exit(0);
         }
 
-        threadTidAvailability[tid] = OPEN_SPOT;
-        removeThreadFromContainer(tid, readyQueue);
-        removeThreadFromContainer(tid, blockedSet);
-        if (runningThread->getThreadTid() == tid) {
+        Thread *thread = threads[tid];
+        threads[tid] = nullptr;
+        if (thread == running()) {
             switchThread(ThreadAction::TERMINATE);
+            return SUCCESS_EXIT;
+        }
+        if (thread->state == ThreadState::RUNNING) { // on another worker, which terminates it at its next switch.
+            thread->exiting = true;
+            interruptWorkerOf(thread);
+            return SUCCESS_EXIT;
         }
+        unlinkThread(thread);
+        retireThread(thread);
         return SUCCESS_EXIT;
     }
 
@@ -193,23 +803,22 @@ public:
             std::cerr << MAIN_THREAD_BLOCKED_ERR << std::endl;
             return FAILURE_EXIT;
         }
-        if (isThreadBlocked(tid)) {
-            return SUCCESS_EXIT;
-        }
-        if (isThreadSleepy(tid)) { // already in blocked q
-            addSleepThreadToBlocked(tid);
-            return SUCCESS_EXIT;
-        }
-        if (isThreadInContainer(tid, readyQueue)) {
-            moveToBlocked(tid);
+        Thread *thread = threads[tid];
+        if (thread == running()) { // if current one need to be blocked
+            thread->setThreadBlockedStatus(true);
+            switchThread(ThreadAction::BLOCKED);
             return SUCCESS_EXIT;
         }
-        if (runningThread->getThreadTid() == tid) { // if current one need to be blocked
-            runningThread->setThreadBlockedStatus(true);
-            switchThread(ThreadAction::BLOCKED);
+        if (thread->getThreadBlockedStatus()) {
             return SUCCESS_EXIT;
         }
-        return FAILURE_EXIT;
+        thread->setThreadBlockedStatus(true);
+        if (thread->state == ThreadState::READY) {
+            moveToBlocked(thread);
+        } else if (thread->state == ThreadState::RUNNING) { // on another worker, which blocks it at its next switch.
+            interruptWorkerOf(thread);
+        } // else it is sleeping or waiting, so it is already in the blocked list.
+        return SUCCESS_EXIT;
     }
 
     /**
@@ -227,41 +836,268 @@ public:
             return FAILURE_EXIT;
         }
 
-        auto it = blockedSet.begin();
-        while (it != blockedSet.end()) {
-            if ((*it)->getThreadTid() == static_cast<unsigned int>(tid)) {
-                (*it)->setThreadBlockedStatus(false);
-                if ((*it)->getThreadSleepCounter() == 0) {
-                    readyQueue.push_back(*it);
-                    it = blockedSet.erase(it); // Erase and get next iterator
-                } else {
-                    ++it;
-                }
-                return SUCCESS_EXIT;
-            } else {
-                ++it;
-            }
+        Thread *thread = threads[tid];
+        traceEvent(currentWorker(), TRACE_RESUME, tid, 0);
+        if (thread->state == ThreadState::RUNNING) { // blocked on another worker that has not switched it out yet.
+            thread->setThreadBlockedStatus(false);
+            return SUCCESS_EXIT;
+        }
+        if (thread->state != ThreadState::BLOCKED) {
+            return SUCCESS_EXIT;
+        }
+        thread->setThreadBlockedStatus(false);
+        if (!thread->isSleeping() && !thread->isWaitingIo() && !thread->isWaitingSync()) {
+            wakeUp(thread);
+            preemptIfOutranked();
         }
         return SUCCESS_EXIT;
     }
 
-
     /**
-     * @brief Puts a thread to sleep.
-     * @param sleepQuantums the number of quantums to sleep.
-     * @return 0 if the thread was successfully put to sleep and -1 otherwise.
+     * @brief Sets the priority of a thread, which is also its base priority under UTHREAD_POLICY_MLFQ.
+     * @param tid the thread id.
+     * @param priority the new priority.
+     * @return 0 if the priority was successfully set and -1 otherwise.
      */
-    int sleepThread(int sleepQuantums) {
-        if (sleepQuantums < 0) {
-            std::cerr << INVALID_QUANTUM_ERR << std::endl;
+    int setPriority(int tid, int priority) {
+        if (!isValidTid(tid)) {
+            std::cerr << INVALID_TID_ERR << std::endl;
             return FAILURE_EXIT;
         }
-        if (runningThread->getThreadTid() == 0) {
-            std::cerr << INVALID_SLEEP_REQUEST_TO_MAIN_THREAD_ERR << std::endl;
+        if (!DoseThreadExists(tid)) {
+            std::cerr << UNDEFINED_TID_ERR << std::endl;
             return FAILURE_EXIT;
         }
-        runningThread->setThreadSleepCounter(sleepQuantums);
-        switchThread(ThreadAction::BLOCKED);
+        if (!isValidPriority(priority)) {
+            std::cerr << INVALID_PRIORITY_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (multiWorker && priority != UTHREAD_DEFAULT_PRIORITY) {
+            std::cerr << PRIORITY_WITH_WORKERS_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        changePriority(threads[tid], priority);
+        threads[tid]->basePriority = priority;
+        preemptIfOutranked();
+        return SUCCESS_EXIT;
+    }
+
+
+    /**
+     * @brief Puts a thread to sleep.
+     * @param sleepQuantums the number of quantums to sleep.
+     * @return 0 if the thread was successfully put to sleep and -1 otherwise.
+     */
+    int sleepThread(int sleepQuantums) {
+        if (sleepQuantums < 0) {
+            std::cerr << INVALID_QUANTUM_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        countAllTicklessQuantums();
+        return sleepThreadUntil(totalNumOfQuantumsCount + sleepQuantums);
+    }
+
+    /**
+     * @brief Puts a thread to sleep until a total quantum starts.
+     * @param wakeQuantum the total quantum to wake up at.
+     * @return 0 if the thread was successfully put to sleep and -1 otherwise.
+     */
+    int sleepThreadUntil(int wakeQuantum) {
+        countAllTicklessQuantums();
+        if (wakeQuantum < totalNumOfQuantumsCount) {
+            std::cerr << INVALID_WAKE_QUANTUM_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        Thread *thread = running();
+        if (thread->getThreadTid() == 0) {
+            std::cerr << INVALID_SLEEP_REQUEST_TO_MAIN_THREAD_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        // The quantum of the calling thread is not counted, so the earliest it can wake up is the next switch.
+        if (wakeQuantum == totalNumOfQuantumsCount) {
+            wakeQuantum++;
+        }
+        thread->setThreadWakeQuantum(wakeQuantum);
+        traceEvent(currentWorker(), TRACE_SLEEP, (int) thread->getThreadTid(), wakeQuantum);
+        sleepQueue.push(thread);
+        resumeTicks();
+        switchThread(ThreadAction::BLOCKED);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Parks the running thread until a file descriptor is ready for I/O.
+     * @param fd the file descriptor.
+     * @param write true to wait until it is writable, false until it is readable.
+     * @return 0 once the file descriptor is ready and -1 otherwise, with errno set if epoll has refused it.
+     */
+    int waitForIo(int fd, bool write) {
+        if (ioPoller.isWaitedOn(fd, write)) {
+            std::cerr << IO_BUSY_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        Thread *thread = running();
+        if (ioPoller.add(thread, fd, write) < 0) {
+            return FAILURE_EXIT;
+        }
+        thread->ioFd = fd;
+        resumeTicks();
+        switchThread(ThreadAction::BLOCKED);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Locks a mutex that was not found unlocked, waiting for it to be handed over if it is still locked.
+     * @param mutex the mutex.
+     */
+    void lockMutex(uthread_mutex_t *mutex) {
+        if (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) == MUTEX_UNLOCKED) {
+            return;
+        }
+        park(mutex->waiters);
+    }
+
+    /**
+     * @brief Unlocks a mutex that was found contended.
+     * @param mutex the mutex.
+     * @return 0 if the mutex was unlocked and -1 if it was not locked.
+     */
+    int unlockMutex(uthread_mutex_t *mutex) {
+        if (__atomic_load_n(&mutex->state, __ATOMIC_RELAXED) == MUTEX_UNLOCKED) {
+            std::cerr << MUTEX_NOT_LOCKED_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        releaseMutex(mutex);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Unlocks a mutex and waits on a condition variable.
+     * @param cond the condition variable.
+     * @param mutex the mutex.
+     * @return 0 once signaled and -1 if the mutex was not locked.
+     */
+    int waitCondition(uthread_cond_t *cond, uthread_mutex_t *mutex) {
+        if (__atomic_load_n(&mutex->state, __ATOMIC_RELAXED) == MUTEX_UNLOCKED) {
+            std::cerr << MUTEX_NOT_LOCKED_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        // Queued before the mutex is released, so a thread that locks it and signals sees this one waiting.
+        WaitQueue(cond->waiters).push(running());
+        releaseMutex(mutex);
+        switchThread(ThreadAction::BLOCKED);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Wakes up the threads waiting on a condition variable.
+     * @param cond the condition variable.
+     * @param all true to wake up all of them, false for the first one.
+     */
+    void signalCondition(uthread_cond_t *cond, bool all) {
+        WaitQueue waiters(cond->waiters);
+        while (!waiters.empty()) {
+            unparkFirst(cond->waiters);
+            if (!all) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Decrements a semaphore that was found 0, waiting for a unit to be handed over if it still is.
+     * @param sem the semaphore.
+     */
+    void waitSemaphore(uthread_sem_t *sem) {
+        int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+        while (true) {
+            if (value >= SEM_UNIT) {
+                if (__atomic_compare_exchange_n(&sem->value, &value, value - SEM_UNIT, false, __ATOMIC_ACQUIRE,
+                                                __ATOMIC_RELAXED)) {
+                    return;
+                }
+            } else if (__atomic_compare_exchange_n(&sem->value, &value, value | SEM_WAITERS, false, __ATOMIC_RELAXED,
+                                                   __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        park(sem->waiters);
+    }
+
+    /**
+     * @brief Increments a semaphore that was found with waiters, handing the unit over to the first one.
+     * @param sem the semaphore.
+     */
+    void postSemaphore(uthread_sem_t *sem) {
+        WaitQueue waiters(sem->waiters);
+        if (waiters.empty()) { // its waiters were terminated, adding 1 to the set SEM_WAITERS bit clears it too.
+            __atomic_fetch_add(&sem->value, SEM_WAITERS, __ATOMIC_RELEASE);
+            return;
+        }
+        unparkFirst(sem->waiters);
+        if (waiters.empty()) {
+            __atomic_fetch_and(&sem->value, ~SEM_WAITERS, __ATOMIC_RELAXED);
+        }
+    }
+
+    /**
+     * @brief Creates a periodic thread, if the periodic threads still fit in the cpu with it.
+     * @param entryPoint the entry point of the thread.
+     * @param period the quantums between its releases.
+     * @param budget the quantums it may run each period.
+     * @return the thread id.
+     */
+    int spawnPeriodic(thread_entry_point entryPoint, int period, int budget) {
+        if (multiWorker) {
+            std::cerr << PERIODIC_WITH_WORKERS_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (period <= 0 || budget <= 0 || budget > period) {
+            std::cerr << INVALID_PERIOD_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (periodicUtilization + (double) budget / period > 1 + UTILIZATION_EPSILON) {
+            std::cerr << PERIODIC_ADMISSION_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        countAllTicklessQuantums();
+        return createThread(entryPoint, 0, UTHREAD_DEFAULT_PRIORITY, period, budget);
+    }
+
+    /**
+     * @brief Ends the job of the running periodic thread, which waits for its next release.
+     * @return 0 on success and -1 if the running thread is not periodic.
+     */
+    int waitPeriod() {
+        Thread *thread = running();
+        if (thread->period == 0) {
+            std::cerr << NOT_PERIODIC_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        countAllTicklessQuantums();
+        if (totalNumOfQuantumsCount >= thread->deadline) { // late, its next job starts at once.
+            renewPeriod(thread, totalNumOfQuantumsCount);
+            return SUCCESS_EXIT;
+        }
+        thread->jobDone = true;
+        if (thread->deadline - 1 == totalNumOfQuantumsCount) { // released at the next quantum.
+            switchThread(ThreadAction::CYCLE);
+            return SUCCESS_EXIT;
+        }
+        waitForRelease(thread);
+        switchThread(ThreadAction::BLOCKED);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Moves the running thread to the end of the ready queue, starting a new quantum.
+     * @return 0.
+     */
+    int yieldThread() {
+        if (policy == UTHREAD_POLICY_FAIR && !fairQueue.empty()) { // it goes after the next thread at least.
+            running()->vruntime = std::max(running()->vruntime, fairQueue.top()->vruntime);
+        }
+        switchThread(ThreadAction::CYCLE);
         return SUCCESS_EXIT;
     }
 
@@ -278,66 +1114,275 @@ public:
             std::cerr << UNDEFINED_TID_ERR << std::endl;
             return FAILURE_EXIT;
         }
-        if (runningThread->getThreadTid() == static_cast<unsigned int>(tid)) {
-            return runningThread->getThreadQuantumCounter();
+        countAllTicklessQuantums();
+        return threads[tid]->getThreadQuantumCounter();
+    }
+
+    /**
+     * @brief Gets how deep a thread has used its stack.
+     * @param tid the thread id.
+     * @return the bytes from the lowest page of the stack the thread touched to its top, or -1 on failure.
+     */
+    int getStackHighWater(int tid) {
+        if (!isValidTid(tid)) {
+            std::cerr << INVALID_TID_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (!DoseThreadExists(tid)) {
+            std::cerr << UNDEFINED_TID_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        Thread *thread = threads[tid];
+        if (thread->stack == nullptr) {
+            std::cerr << MAIN_STACK_ERR << std::endl;
+            return FAILURE_EXIT;
         }
-        for (const auto &thread: readyQueue) {
-            if (thread->getThreadTid() == static_cast<unsigned int>(tid)) {
-                return thread->getThreadQuantumCounter();
-            }
+        return (int) stackPool.highWaterMark(thread->stack, thread->stackSize);
+    }
+
+    /**
+     * @brief Gets the scheduling statistics of a thread, or of all the threads.
+     * @param tid the thread id, or ALL_THREADS.
+     * @param stats receives the statistics.
+     * @return 0 on success and -1 otherwise.
+     */
+    int getStats(int tid, struct uthread_stats *stats) {
+        if (stats == nullptr) {
+            std::cerr << INVALID_STATS_ERR << std::endl;
+            return FAILURE_EXIT;
         }
-        for (const auto &thread: blockedSet) {
-            if (thread->getThreadTid() == static_cast<unsigned int>(tid)) {
-                return thread->getThreadQuantumCounter();
+        if (tid == ALL_THREADS) {
+            *stats = retiredStats;
+            for (Thread *thread: threads) {
+                if (thread != nullptr) {
+                    addStats(*stats, currentStats(thread));
+                }
             }
+            stats->quantum_usecs = currentWorker()->quantumNsec / 1000;
+            return SUCCESS_EXIT;
         }
-        return FAILURE_EXIT;
+        if (!isValidTid(tid)) {
+            std::cerr << INVALID_TID_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        if (!DoseThreadExists(tid)) {
+            std::cerr << UNDEFINED_TID_ERR << std::endl;
+            return FAILURE_EXIT;
+        }
+        *stats = currentStats(threads[tid]);
+        return SUCCESS_EXIT;
+    }
+
+    /**
+     * @brief Gets the statistics of a thread, including its current run or ready wait.
+     * @param thread the thread.
+     * @return the statistics.
+     */
+    struct uthread_stats currentStats(const Thread *thread) const {
+        struct uthread_stats stats = thread->stats;
+        if (thread->state == ThreadState::RUNNING) {
+            stats.run_nsec += monotonicNsec() - thread->runSinceNsec;
+        } else if (thread->state == ThreadState::READY) {
+            stats.ready_nsec += monotonicNsec() - thread->readySinceNsec;
+        }
+        return stats;
     }
 
     /**
      * @brief Switches the thread.
      * @param action the action to take.
+     * @param preempted true when the running thread used up its whole quantum.
      */
-    void switchThread(ThreadAction action) {
-        updateSleepCounters();
+    void switchThread(ThreadAction action, bool preempted = false) {
+        Worker *worker = currentWorker();
+        Thread *previous = worker->runningThread;
+        long decidedNsec = monotonicNsec();
+        countTicklessQuantums(worker);
+        if (preempted) {
+            countPreemptLateness(worker, previous);
+        }
+        if (policy == UTHREAD_POLICY_FAIR) {
+            chargeVruntime(previous, decidedNsec);
+        }
+        if (action == ThreadAction::CYCLE && previous->period != 0 && previous->budgetLeft <= 0 &&
+            previous->deadline - 1 > totalNumOfQuantumsCount) { // used up its budget, throttled until its release.
+            waitForRelease(previous);
+            action = ThreadAction::BLOCKED;
+        }
+        if (adaptiveQuantum && action != ThreadAction::TERMINATE) {
+            voluntaryRate += ((preempted ? 0 : ADAPTIVE_RATE_ONE) - voluntaryRate) / ADAPTIVE_RATE_WEIGHT;
+        }
+        if (action == ThreadAction::CYCLE && previous->exiting) { // terminated by another worker.
+            action = ThreadAction::TERMINATE;
+        } else if (action == ThreadAction::CYCLE && previous->getThreadBlockedStatus()) { // blocked by another worker.
+            action = ThreadAction::BLOCKED;
+        }
 
-        if (sigsetjmp(runningThread->env, 1) != 0) {
-            return;
+        wakeUpSleepers();
+        // Polling is a system call, so with threads ready to run it is done once a quantum rather than every switch.
+        if (ioPoller.hasWaiters() &&
+            (!hasReady() || decidedNsec - ioPolledNsec >= std::max((long) quantumUsecs, 1000L) * 1000L)) {
+            pollIo(0);
+            ioPolledNsec = decidedNsec;
+        }
+        if (policy == UTHREAD_POLICY_MLFQ && totalNumOfQuantumsCount >= nextBoostQuantum) {
+            boostPriorities();
         }
 
         if (action == ThreadAction::CYCLE) {
-            if (!readyQueue.empty()) {
-                readyQueue.push_back(runningThread);
-            } else {
-                unsigned int cur = runningThread->getThreadQuantumCounter() + 1;
-                runningThread->setThreadQuantumCounter(cur);
-                totalNumOfQuantumsCount++;
+            if (policy == UTHREAD_POLICY_MLFQ && preempted) { // CPU bound, demoted.
+                changePriority(previous, std::min(previous->priority + 1, UTHREAD_PRIORITY_LEVELS - 1));
+            }
+            if (!hasReady()) { // the running thread goes on, with a new quantum.
+                startQuantum(worker, previous);
                 return;
             }
-        } else if (action == ThreadAction::TERMINATE) {
-            delete runningThread;
-            runningThread = nullptr;
-        } else if (action == ThreadAction::BLOCKED) {
-            blockedSet.insert(runningThread);
+            pushReady(previous);
+        } else if (action == ThreadAction::TERMINATE) { // still running on its stack, freed by finishSwitch.
+            worker->zombie = previous;
+        } else if (action == ThreadAction::BLOCKED && previous->state != ThreadState::READY) { // else the poll above
+            // found the file descriptor it waits on ready already, and queued it.
+            if (policy == UTHREAD_POLICY_MLFQ) { // gave up the cpu early, boosted.
+                previous->priority = std::max(previous->priority - 1, previous->basePriority);
+            }
+            previous->state = ThreadState::BLOCKED;
+            blockedList.pushBack(previous);
         }
 
-        if (!readyQueue.empty()) {
-            runningThread = readyQueue.front();
-            readyQueue.pop_front();
-        } else {
-            std::cerr << EMPTY_READY_Q_ERR << std::endl;
-            exit(1);
+        Thread *next = takeReady(worker);
+        if (next == nullptr) {
+            stopTheClock(worker);
+            if (!multiWorker) {
+                next = waitForReady(worker);
+            }
         }
+        worker->runningThread = next;
+        if (next != previous) {
+            switchOut(worker, previous, action, preempted, decidedNsec);
+        }
+        if (next == nullptr) {
+            contextSwitch(previous->context, worker->idleContext);
+            finishSwitch();
+            return;
+        }
+        startQuantum(worker, next);
 
-        unsigned int cur = runningThread->getThreadQuantumCounter() + 1;
-        runningThread->setThreadQuantumCounter(cur);
-        totalNumOfQuantumsCount++;
+        if (next == previous) { // it outranks every ready thread, and goes on with a new quantum.
+            return;
+        }
+        // Every switch happens inside a critical section, and each thread ends it on its own way out (returning from
+        // the timer handler or from the library call), so the flag is not saved and restored per switch.
+        // With several workers the engine lock is handed over the same way, and the thread may go on on another
+        // kernel thread, so nothing read before the switch about the current worker is used after it.
+        contextSwitch(previous->context, next->context);
+        finishSwitch();
+    }
+
+    /**
+     * @brief Completes a switch on the stack of the thread that was switched to.
+     */
+    void finishSwitch() {
+        Worker *worker = currentWorker();
+        reapZombie(worker);
+        if (worker->runningThread != nullptr) {
+            switchIn(worker, worker->runningThread);
+        }
+    }
 
-        restartTheClock();
+    /**
+     * @brief Counts the end of a run of a thread that is switched out.
+     * @param worker the current worker.
+     * @param thread the thread.
+     * @param action the action the thread is switched out by.
+     * @param preempted true when the thread used up its whole quantum.
+     * @param decidedNsec when the switch was decided.
+     */
+    void switchOut(Worker *worker, Thread *thread, ThreadAction action, bool preempted, long decidedNsec) {
+        thread->stats.run_nsec += decidedNsec - thread->runSinceNsec;
+        if (preempted) {
+            thread->stats.involuntary_switches++;
+        } else if (action != ThreadAction::TERMINATE) {
+            thread->stats.voluntary_switches++;
+        }
+        worker->switchStartNsec = decidedNsec;
+        traceEvent(worker, TRACE_SWITCH_OUT, (int) thread->getThreadTid(),
+                   action == ThreadAction::CYCLE ? TRACE_CYCLE
+                                                 : action == ThreadAction::BLOCKED ? TRACE_BLOCKED : TRACE_TERMINATE);
+    }
+
+    /**
+     * @brief Counts the start of a run of a thread that was switched to, on its stack.
+     * @param worker the current worker.
+     * @param thread the thread.
+     */
+    void switchIn(Worker *worker, Thread *thread) {
+        long now = monotonicNsec();
+        countInHistogram(thread->stats.switch_latency, now - worker->switchStartNsec);
+        if (thread->readySinceNsec != 0) {
+            thread->stats.ready_nsec += now - thread->readySinceNsec;
+            thread->readySinceNsec = 0;
+        }
+        thread->runSinceNsec = now;
+        traceEvent(worker, TRACE_SWITCH_IN, (int) thread->getThreadTid(), 0);
+    }
 
-        siglongjmp(runningThread->env, 1);
+    /**
+     * @brief Counts how late a preemption lands after the end of the quantum, from the worker's periodic timer.
+     * @param worker the current worker.
+     * @param thread the preempted thread.
+     */
+    void countPreemptLateness(Worker *worker, Thread *thread) {
+        struct itimerspec left{};
+        if (!preemptive || quantumUsecs == 0 || worker->tickless || timer_gettime(worker->timer, &left) < 0 ||
+            (left.it_value.tv_sec == 0 && left.it_value.tv_nsec == 0)) {
+            return;
+        }
+        long late = worker->quantumNsec - (left.it_value.tv_sec * 1000000000L + left.it_value.tv_nsec);
+        countInHistogram(thread->stats.preempt_lateness, std::max(late, 0L));
     }
 
+    /**
+     * @brief Runs the ready threads with a worker that has no running thread, stealing them from the other workers.
+     * Runs on the worker's idle context inside a critical section with the engine unlocked, and never returns.
+     * @param worker the current worker.
+     */
+    void idleLoop(Worker *worker) {
+        unsigned int idleRounds = 0;
+        while (true) {
+            // Waits for a ready thread, or with nothing queued polls the threads waiting for I/O if no other worker
+            // is in the engine.
+            bool locked = anyQueued();
+            if (locked) {
+                lockEngine();
+            } else {
+                locked = tryLockEngine();
+            }
+            if (locked) {
+                if (ioPoller.hasWaiters()) {
+                    pollIo(0);
+                }
+                Thread *next = takeReady(worker);
+                if (next != nullptr) {
+                    worker->runningThread = next;
+                    startQuantum(worker, next);
+                    worker->switchStartNsec = monotonicNsec();
+                    contextSwitch(worker->idleContext, next->context);
+                    finishSwitch();
+                    unlockEngine();
+                    idleRounds = 0;
+                    continue;
+                }
+                countIdleQuantum();
+                unlockEngine();
+            }
+            if (++idleRounds < IDLE_SPIN_ROUNDS) {
+                sched_yield();
+            } else {
+                struct timespec pause{0, IDLE_SLEEP_NSEC};
+                nanosleep(&pause, nullptr);
+            }
+        }
+    }
 
 private:
     /**
@@ -345,8 +1390,17 @@ private:
      * @param tid the thread id.
      * @return true if the thread id is valid and false otherwise.
      */
-    static bool isValidTid(int tid) {
-        return tid >= 0 && tid < MAX_THREAD_NUM;
+    bool isValidTid(int tid) const {
+        return tid >= 0 && tid < maxThreads;
+    }
+
+    /**
+     * @brief Checks if the priority is valid.
+     * @param priority the priority.
+     * @return true if the priority is valid and false otherwise.
+     */
+    static bool isValidPriority(int priority) {
+        return priority >= 0 && priority < UTHREAD_PRIORITY_LEVELS;
     }
 
     /**
@@ -355,183 +1409,599 @@ private:
      * @return true if the thread exists and false otherwise.
      */
     bool DoseThreadExists(int tid) const {
-        return threadTidAvailability[tid] == TAKEN_SPOT;
+        return tid < (int) threads.size() && threads[tid] != nullptr;
     }
 
     /**
      * @brief Clears the threads.
      */
     void clearThreads() {
-        readyQueue.clear();
-        blockedSet.clear();
-        delete runningThread;
-        runningThread = nullptr;
+        for (auto &queue: readyQueues) {
+            queue.clear();
+        }
+        readyLevels = 0;
+        readyCount = 0;
+        deadlineQueue.clear();
+        periodicUtilization = 0;
+        fairQueue.clear();
+        minVruntime = 0;
+        blockedList.clear();
+        sleepQueue.clear();
+        for (auto &thread: threads) {
+            delete thread;
+            thread = nullptr;
+        }
+        for (Worker *worker: workers) {
+            worker->runningThread = nullptr;
+        }
     }
 
     /**
-     * @brief Gets the next available thread id.
-     * @return the next available thread id.
+     * @brief Frees a thread that is not running, releasing its tid and returning its stack to the stack pool.
+     * @param thread the thread.
      */
-    int getNextAvailableTid() const {
-        for (int i = 1; i < MAX_THREAD_NUM; i++) {
-            if (threadTidAvailability[i] == OPEN_SPOT) {
-                return i;
-            }
+    void destroyThread(Thread *thread) {
+        addStats(retiredStats, thread->stats);
+        if (thread->period != 0) {
+            periodicUtilization -= (double) thread->budget / thread->period;
         }
-        return FAILURE_EXIT;
+        tidAllocator.release((int) thread->tid);
+        stackPool.release(thread->stack, thread->stackSize);
+        delete thread;
     }
 
     /**
-     *
-     * @param Checks if the thread is in the set.
-     * @param set the set.
-     * @return The thread and nullptr otherwise.
+     * @brief Frees a terminated thread that is not running, or leaves it to the worker that takes its last entry
+     * from the ready deques if it still has some.
+     * @param thread the thread.
      */
-    static Thread *findThreadInSet(unsigned int tid, const std::unordered_set<Thread *> &set) {
-        for (const auto &thread: set) {
-            if (thread->getThreadTid() == static_cast<unsigned int>(tid)) {
-                return thread;
-            }
+    void retireThread(Thread *thread) {
+        if (thread->queuedCount > 0) {
+            thread->state = ThreadState::TERMINATED;
+        } else {
+            destroyThread(thread);
         }
-        return nullptr;
     }
 
     /**
-     * @brief Checks if the thread is blocked.
-     * @param tid the thread id.
-     * @return true if the thread is blocked and false otherwise.
+     * @brief Frees the thread that terminated itself on a worker, if any. Must be called from another thread's stack.
+     * @param worker the worker.
      */
-    bool isThreadBlocked(int tid) const {
-        Thread *thread = findThreadInSet(tid, blockedSet);
-        return thread != nullptr && thread->getThreadBlockedStatus();
+    void reapZombie(Worker *worker) {
+        if (worker->zombie != nullptr) {
+            retireThread(worker->zombie);
+            worker->zombie = nullptr;
+        }
     }
 
     /**
-     * @brief Checks if the thread is sleepy.
-     * @param tid the thread id.
-     * @return true if the thread is sleepy and false otherwise.
+     * @brief Starts a new quantum of a thread on a worker.
+     * @param worker the worker.
+     * @param thread the thread.
      */
-    bool isThreadSleepy(unsigned int tid) const {
-        Thread *thread = findThreadInSet(tid, blockedSet);
-        return thread != nullptr && thread->getThreadSleepCounter() > 0;
+    void startQuantum(Worker *worker, Thread *thread) {
+        thread->state = ThreadState::RUNNING;
+        unsigned int cur = thread->getThreadQuantumCounter() + 1;
+        thread->setThreadQuantumCounter(cur);
+        totalNumOfQuantumsCount++;
+        if (thread->period != 0) {
+            renewPeriod(thread, totalNumOfQuantumsCount);
+            thread->budgetLeft--;
+        }
+        adaptQuantum(worker);
+        thread->stats.quantum_usecs = worker->quantumNsec / 1000;
+        startQuantumClock(worker);
+        preemptionPending = 0; // a late expiry or interrupt, not meant for the new quantum.
+        if (policy == UTHREAD_POLICY_FAIR) {
+            thread->chargedUntilNsec = monotonicNsec();
+        }
     }
 
     /**
-     * @brief Checks if the thread is in the queue.
-     * @param tid the thread id.
-     * @param container the container.
-     * @return true if the thread is in the queue and false otherwise.
+     * @brief Moves a periodic thread on to the period a quantum is in, counting a deadline miss for every period that
+     * ended without the thread finishing its job. Each new period restores its budget.
+     * @param thread the periodic thread.
+     * @param quantum the quantum.
      */
-    template<typename Container>
-    static bool isThreadInContainer(int tid, const Container &container) {
-        for (const auto &thread: container) {
-            if (thread->getThreadTid() == static_cast<unsigned int>(tid)) {
-                return true;
+    void renewPeriod(Thread *thread, int quantum) {
+        while (quantum >= thread->deadline) {
+            if (!thread->jobDone) {
+                thread->stats.deadline_misses++;
             }
+            thread->jobDone = false;
+            thread->deadline += thread->period;
+            thread->budgetLeft = thread->budget;
         }
-        return false;
     }
 
     /**
-     * @brief Adds a sleep thread to the blocked queue.
-     * @param tid the thread id.
+     * @brief Puts the running periodic thread to sleep until its next release. It is woken up by the switch that
+     * ends the quantum before, so it is READY when the quantum of its release starts.
+     * @param thread the periodic thread.
      */
-    void addSleepThreadToBlocked(int tid) {
-        for (auto &thread: blockedSet) {
-            if (thread->getThreadTid() == static_cast<unsigned int>(tid)) {
-                thread->setThreadBlockedStatus(true);
-                return;
-            }
+    void waitForRelease(Thread *thread) {
+        thread->setThreadWakeQuantum((int) thread->deadline - 1);
+        sleepQueue.push(thread);
+        resumeTicks();
+    }
+
+    /**
+     * @brief Adds the run time of a running thread since it was last charged to its vruntime, weighted by its
+     * priority: the lighter the thread, the faster its vruntime advances.
+     * @param thread the thread.
+     * @param nowNsec the monotonic clock now.
+     */
+    void chargeVruntime(Thread *thread, long nowNsec) {
+        thread->vruntime += (nowNsec - thread->chargedUntilNsec) * FAIR_WEIGHT_UNIT / fairWeights[thread->priority];
+        thread->chargedUntilNsec = nowNsec;
+    }
+
+    /**
+     * @brief Appends a thread to the end of the ready queue of its priority, or to the ready deque of the current
+     * worker with several workers. Under UTHREAD_POLICY_FAIR it goes to the fair heap instead, and a periodic thread
+     * goes to the deadline heap, in the period of the next quantum.
+     * @param thread the thread.
+     */
+    void pushReady(Thread *thread) {
+        thread->state = ThreadState::READY;
+        readyCount++;
+        thread->readySinceNsec = monotonicNsec();
+        resumeTicks();
+        if (multiWorker) {
+            currentWorker()->readyDeque.push(thread);
+            thread->queuedCount++;
+            return;
+        }
+        if (thread->period != 0) {
+            renewPeriod(thread, totalNumOfQuantumsCount + 1);
+            deadlineQueue.push(thread);
+            return;
+        }
+        if (policy == UTHREAD_POLICY_FAIR) {
+            fairQueue.push(thread);
+            return;
         }
+        readyQueues[thread->priority].pushBack(thread);
+        readyLevels |= 1u << thread->priority;
     }
 
     /**
-     * @brief Moves a thread to the blocked queue.
-     * @param tid the thread id.
+     * @brief Removes a ready thread from the ready queue of its priority. With several workers its deque entry stays,
+     * and is skipped by the worker that takes it.
+     * @param thread the thread.
      */
-    void moveToBlocked(int tid) {
-        for (auto it = readyQueue.begin(); it != readyQueue.end(); ++it) {
-            if ((*it)->getThreadTid() == static_cast<unsigned int>(tid)) {
-                Thread *thread = *it;
-                thread->setThreadBlockedStatus(true);
-                blockedSet.insert(thread); // Insert into unordered_set
-                readyQueue.erase(it); // Remove from deque
-                break;
-            }
+    void eraseReady(Thread *thread) {
+        readyCount--;
+        if (multiWorker) {
+            return;
+        }
+        if (thread->period != 0) {
+            deadlineQueue.remove(thread);
+            return;
+        }
+        if (policy == UTHREAD_POLICY_FAIR) {
+            fairQueue.remove(thread);
+            return;
+        }
+        ThreadList &queue = readyQueues[thread->priority];
+        queue.remove(thread);
+        if (queue.empty()) {
+            readyLevels &= ~(1u << thread->priority);
         }
     }
 
     /**
-    * @brief Removes a thread from the container.
-    * @param tid the thread id.
-    * @param container the container (e.g., deque, unordered_set).
-    * @tparam Container the type of container (e.g., deque<Thread*>, unordered_set<Thread*>).
-    */
-    template<typename Container>
-    static void removeThreadFromContainer(int tid, Container &container) {
-        for (auto it = container.begin(); it != container.end(); ++it) {
-            if ((*it)->getThreadTid() == static_cast<unsigned int>(tid)) {
-                delete *it;
-                container.erase(it);
-                return;
-            }
+     * @brief Removes the periodic thread of the earliest deadline, or else the first thread of the highest priority
+     * ready queue, or under UTHREAD_POLICY_FAIR the thread of the least vruntime. There must be a ready thread.
+     * @return the thread.
+     */
+    Thread *popReady() {
+        if (!deadlineQueue.empty()) {
+            readyCount--;
+            return deadlineQueue.pop();
+        }
+        if (policy == UTHREAD_POLICY_FAIR) {
+            Thread *thread = fairQueue.pop();
+            readyCount--;
+            minVruntime = std::max(minVruntime, thread->vruntime);
+            return thread;
         }
+        Thread *thread = readyQueues[__builtin_ctz(readyLevels)].front();
+        eraseReady(thread);
+        return thread;
     }
 
     /**
-     * @brief Updates the sleep counters.
+     * @brief Takes the next thread to run on a worker: the first of the highest priority ready queue, or with several
+     * workers the oldest thread of the worker's own deque, stealing the oldest thread of another worker's deque when
+     * its own is empty.
+     * @param worker the current worker.
+     * @return the thread, or nullptr if no thread is ready.
      */
-    void updateSleepCounters() {
-        for (auto it = blockedSet.begin(); it != blockedSet.end();) {
-            if ((*it)->getThreadSleepCounter() > 0) {
-                Thread *thread = *it;
-                unsigned int cur = thread->getThreadSleepCounter() - 1;
-                thread->setThreadSleepCounter(cur);
-            }
-            if ((*it)->getThreadSleepCounter() == 0 && !(*it)->getThreadBlockedStatus()) { // back to ready.
-                readyQueue.push_back(*it);
-                it = blockedSet.erase(it); // Erase and get next iterator
-            } else {
-                ++it;
+    Thread *takeReady(Worker *worker) {
+        if (!multiWorker) {
+            return hasReady() ? popReady() : nullptr;
+        }
+        for (size_t i = 0; i < workers.size(); i++) {
+            Worker *victim = workers[(worker->index + i) % workers.size()];
+            Thread *thread;
+            while ((thread = victim->readyDeque.steal()) != nullptr) {
+                thread->queuedCount--;
+                if (thread->state == ThreadState::READY) {
+                    readyCount--;
+                    return thread;
+                }
+                if (thread->state == ThreadState::TERMINATED && thread->queuedCount == 0) {
+                    destroyThread(thread);
+                } // else a stale entry, of a thread that was blocked or already taken through a later entry.
             }
         }
+        return nullptr;
     }
-};
 
-ThreadsEngine threadsEngine;
+    /**
+     * @brief Checks if a thread is ready to replace the running one.
+     * @return true if a thread may be ready, with several workers some of the deque entries may be stale.
+     */
+    bool hasReady() const {
+        if (multiWorker) {
+            return anyQueued();
+        }
+        return !deadlineQueue.empty() || (policy == UTHREAD_POLICY_FAIR ? !fairQueue.empty() : readyLevels != 0);
+    }
+
+    /**
+     * @brief Checks if any worker's ready deque has entries, without the engine lock.
+     * @return true if a deque looked non-empty.
+     */
+    bool anyQueued() const {
+        for (Worker *worker: workers) {
+            if (!worker->readyDeque.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Sends SIGVTALRM to the worker running a thread, so it switches the thread out at once.
+     * In cooperative runs the worker does so at the thread's next library call.
+     * @param thread a thread running on another worker.
+     */
+    void interruptWorkerOf(Thread *thread) {
+        if (!preemptive) {
+            return;
+        }
+        for (Worker *worker: workers) {
+            if (worker->runningThread == thread) {
+                pthread_kill(worker->kernelThread, SIGVTALRM);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Changes the priority of a thread, moving it to the end of its new ready queue if it is ready.
+     * @param thread the thread.
+     * @param priority the new priority.
+     */
+    void changePriority(Thread *thread, int priority) {
+        if (thread->priority == priority) {
+            return;
+        }
+        if (thread->state == ThreadState::READY) {
+            eraseReady(thread);
+            thread->priority = priority;
+            pushReady(thread);
+        } else {
+            thread->priority = priority;
+        }
+    }
+
+    /**
+     * @brief Switches to a ready thread if it has a higher priority than the running one. Under UTHREAD_POLICY_FAIR
+     * the ready threads wait for the end of the running quantum instead. A ready periodic thread outranks the threads
+     * that are not periodic, and the periodic threads of later deadlines.
+     */
+    void preemptIfOutranked() {
+        Thread *thread = running();
+        if (!deadlineQueue.empty() && (thread->period == 0 || deadlineQueue.top()->deadline < thread->deadline)) {
+            switchThread(ThreadAction::CYCLE);
+            return;
+        }
+        if (thread->period == 0 && readyLevels != 0 && __builtin_ctz(readyLevels) < thread->priority) {
+            switchThread(ThreadAction::CYCLE);
+        }
+    }
+
+    /**
+     * @brief Resets every thread to its base priority, so the threads demoted as CPU bound don't starve.
+     */
+    void boostPriorities() {
+        for (Thread *thread: threads) {
+            if (thread != nullptr) {
+                changePriority(thread, thread->basePriority);
+            }
+        }
+        nextBoostQuantum = totalNumOfQuantumsCount + MLFQ_BOOST_PERIOD;
+    }
+
+    /**
+     * @brief Moves a ready thread to the blocked list.
+     * @param thread the thread.
+     */
+    void moveToBlocked(Thread *thread) {
+        eraseReady(thread);
+        thread->state = ThreadState::BLOCKED;
+        blockedList.pushBack(thread);
+    }
+
+    /**
+     * @brief Moves a thread that no longer waits back to ready, out of the blocked list unless it has not been
+     * switched out yet (a poll in the switch that blocks it found its file descriptor ready).
+     * Under UTHREAD_POLICY_FAIR a thread that slept long keeps only a small credit on the threads that ran meanwhile,
+     * so it runs soon without holding the cpu until it catches up with them.
+     * @param thread the thread.
+     */
+    void wakeUp(Thread *thread) {
+        if (thread->state == ThreadState::BLOCKED) {
+            blockedList.remove(thread);
+        }
+        if (policy == UTHREAD_POLICY_FAIR) {
+            thread->vruntime = std::max(thread->vruntime, minVruntime - FAIR_SLEEPER_CREDIT_NSEC);
+        }
+        pushReady(thread);
+    }
+
+    /**
+     * @brief Removes a thread that is not running from the container its state says it is in.
+     * @param thread the thread.
+     */
+    void unlinkThread(Thread *thread) {
+        if (thread->state == ThreadState::READY) {
+            eraseReady(thread);
+        } else if (thread->state == ThreadState::BLOCKED) {
+            blockedList.remove(thread);
+            if (thread->isSleeping()) {
+                sleepQueue.remove(thread);
+            }
+            if (thread->isWaitingIo()) {
+                ioPoller.remove(thread);
+            }
+            if (thread->isWaitingSync()) {
+                WaitQueue::remove(thread);
+            }
+        }
+    }
+
+    /**
+     * @brief Parks the running thread in the wait queue of a synchronization object, until another thread hands it
+     * what it waits for.
+     * @param queue the wait queue.
+     */
+    void park(uthread_wait_queue &queue) {
+        WaitQueue(queue).push(running());
+        switchThread(ThreadAction::BLOCKED);
+    }
+
+    /**
+     * @brief Wakes up the first thread of a wait queue, which must not be empty.
+     * A woken up thread that is also blocked stays in the blocked list until it is resumed.
+     * @param queue the wait queue.
+     */
+    void unparkFirst(uthread_wait_queue &queue) {
+        Thread *thread = WaitQueue(queue).pop();
+        if (!thread->getThreadBlockedStatus()) { // back to ready.
+            wakeUp(thread);
+        }
+    }
+
+    /**
+     * @brief Unlocks a mutex, handing it over to its first waiter if any, who goes on with the mutex locked.
+     * @param mutex a locked mutex.
+     */
+    void releaseMutex(uthread_mutex_t *mutex) {
+        if (WaitQueue(mutex->waiters).empty()) {
+            __atomic_store_n(&mutex->state, MUTEX_UNLOCKED, __ATOMIC_RELEASE);
+            return;
+        }
+        unparkFirst(mutex->waiters); // the mutex stays MUTEX_CONTENDED.
+    }
+
+    /**
+     * @brief Wakes up the threads whose file descriptor is ready for I/O.
+     * A woken up thread that is also blocked stays in the blocked list until it is resumed.
+     * @param timeoutMs the longest time to wait for one in milliseconds, 0 to poll and -1 to wait until there is one.
+     * @return the number of threads woken up.
+     */
+    int pollIo(int timeoutMs) {
+        ioReady.clear();
+        if (ioPoller.wait(timeoutMs, ioReady) < 0) {
+            std::cerr << EPOLL_ERR << std::endl;
+            exit(1);
+        }
+        for (Thread *thread: ioReady) {
+            thread->ioFd = NO_IO_WAIT;
+            if (!thread->getThreadBlockedStatus()) { // back to ready.
+                wakeUp(thread);
+            }
+        }
+        return (int) ioReady.size();
+    }
+
+    /**
+     * @brief Waits until a thread is ready, when none is with a single worker. Only threads waiting for I/O or
+     * sleeping can become ready then, so the process sleeps in the poller, or for a quantum if no thread waits for
+     * I/O; each quantum it sleeps while threads are sleeping is counted, so they wake up too.
+     * @param worker the current worker.
+     * @return the thread to run.
+     */
+    Thread *waitForReady(Worker *worker) {
+        while (true) {
+            if (!ioPoller.hasWaiters() && sleepQueue.empty()) { // nothing can ever become ready.
+                std::cerr << EMPTY_READY_Q_ERR << std::endl;
+                exit(1);
+            }
+            int timeoutMs = sleepQueue.empty() ? -1 : std::max((int) (quantumUsecs + 999) / 1000, 1);
+            int woken = 0;
+            if (ioPoller.hasWaiters()) {
+                woken = pollIo(timeoutMs);
+            } else {
+                struct timespec quantum = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+                nanosleep(&quantum, nullptr);
+            }
+            if (woken == 0 && !sleepQueue.empty()) {
+                totalNumOfQuantumsCount++;
+                wakeUpSleepers();
+            }
+            Thread *next = takeReady(worker);
+            if (next != nullptr) {
+                return next;
+            }
+        }
+    }
+
+    /**
+     * @brief Counts a quantum for each quantum of time every worker spends idle while threads are sleeping, with
+     * several workers, so the sleeping threads wake up even though no thread runs to start quantums.
+     */
+    void countIdleQuantum() {
+        bool allIdle = std::all_of(workers.begin(), workers.end(),
+                                   [](const Worker *worker) { return worker->runningThread == nullptr; });
+        if (sleepQueue.empty() || !allIdle) {
+            idleSinceNsec = 0;
+            return;
+        }
+        long nowNsec = monotonicNsec();
+        if (idleSinceNsec == 0) {
+            idleSinceNsec = nowNsec;
+        } else if (nowNsec - idleSinceNsec >= std::max((long) quantumUsecs, 1000L) * 1000L) {
+            totalNumOfQuantumsCount++;
+            wakeUpSleepers();
+            idleSinceNsec = nowNsec;
+        }
+    }
+
+    /**
+     * @brief Wakes up the threads whose wake up quantum has come, only touching the threads that are due.
+     * A woken up thread that is also blocked stays in the blocked list until it is resumed.
+     */
+    void wakeUpSleepers() {
+        while (!sleepQueue.empty() && sleepQueue.top()->getThreadWakeQuantum() <= totalNumOfQuantumsCount) {
+            Thread *thread = sleepQueue.pop();
+            if (!thread->getThreadBlockedStatus()) { // back to ready.
+                wakeUp(thread);
+            }
+        }
+    }
+};
+
+// Never destroyed: the other workers may still peek at it while the process exits.
+ThreadsEngine &threadsEngine = *new ThreadsEngine();
+
+/**
+ * @brief Switches the running thread out at the end of its quantum, inside a critical section.
+ */
+static void preemptRunningThread() {
+    if (threadsEngine.multiWorker) {
+        lockEngine();
+        threadsEngine.switchThread(ThreadAction::CYCLE, true);
+        unlockEngine();
+        return;
+    }
+    threadsEngine.switchThread(ThreadAction::CYCLE, true);
+}
 
 /**
- * @brief The timer handler.
+ * @brief Ends a critical section, running the preemptions deferred during it.
+ */
+static void leaveCriticalSection() {
+    while (exitCriticalSection()) {
+        preemptRunningThread();
+    }
+}
+
+/**
+ * @brief The timer handler. Inside a critical section it only records the preemption, which runs at its end.
  * @param sig the signal.
  */
 void timerHandler(int sig) {
-    threadsEngine.switchThread(ThreadAction::CYCLE);
+    Worker *worker = currentWorker();
+    Thread *running = worker->runningThread;
+    threadsEngine.traceEvent(worker, TRACE_TIMER, running != nullptr ? (int) running->getThreadTid() : -1,
+                             inCriticalSection);
+    if (inCriticalSection) {
+        preemptionPending = 1;
+        return;
+    }
+    enterCriticalSection();
+    preemptRunningThread();
+    leaveCriticalSection();
 }
 
 /**
- * blocks the signals.
+ * @brief Enters the engine from a library call: enters a critical section, and with several workers takes the engine
+ * lock. A thread terminated by another worker while it was running terminates here.
  */
-void blockSignal() {
-    sigset_t set;
-    sigemptyset(&set);
-    sigaddset(&set, SIGVTALRM);
-    if (sigprocmask(SIG_BLOCK, &set, nullptr) == -1) {
-        std::cerr << SIGPROCMASK_ERR << std::endl;
-        exit(1);
+void enterEngine() {
+    enterCriticalSection();
+    if (!threadsEngine.multiWorker) {
+        return;
+    }
+    lockEngine();
+    if (threadsEngine.running()->exiting) {
+        threadsEngine.switchThread(ThreadAction::TERMINATE);
     }
 }
 
 /**
- * unblocks the signals.
+ * @brief Leaves the engine at the end of a library call.
  */
-void unblockSignal() {
-    sigset_t set;
-    sigemptyset(&set);
-    sigaddset(&set, SIGVTALRM);
-    if (sigprocmask(SIG_UNBLOCK, &set, nullptr) == -1) {
-        std::cerr << SIGPROCMASK_ERR << std::endl;
-        exit(1);
+void leaveEngine() {
+    if (threadsEngine.multiWorker) {
+        unlockEngine();
     }
+    leaveCriticalSection();
+}
+
+/**
+ * @brief The function every spawned thread starts running at, on its own stack.
+ * It is switched to inside a critical section, like every switch, and it has no library call or timer handler to
+ * return through, so it ends the critical section itself.
+ */
+void threadTrampoline() {
+    threadsEngine.finishSwitch();
+    thread_entry_point entryPoint = threadsEngine.running()->entryPoint;
+    leaveEngine();
+    entryPoint();
+    uthread_terminate(uthread_get_tid());
+}
+
+/**
+ * @brief The function the idle context of the first worker starts running at, when its thread is switched out with
+ * no ready thread to replace it.
+ */
+void idleTrampoline() {
+    threadsEngine.finishSwitch();
+    unlockEngine();
+    threadsEngine.idleLoop(currentWorker());
+}
+
+/**
+ * @brief The function the kernel threads of the other workers start running at.
+ * @param arg the worker.
+ * @return never returns.
+ */
+void *workerMain(void *arg) {
+    auto worker = static_cast<Worker *>(arg);
+    workerOfKernelThread = worker;
+    inCriticalSection = 1; // the idle loop runs inside a critical section.
+    lockEngine();
+    worker->kernelThread = pthread_self();
+    threadsEngine.createTimer(worker);
+    unlockEngine();
+    threadsEngine.idleLoop(worker);
+    return nullptr;
 }
 
 /**
@@ -540,12 +2010,74 @@ void unblockSignal() {
  * @return 0 if the thread library was successfully initialized and -1 otherwise.
  */
 int uthread_init(int quantum_usecs) {
-    if (quantum_usecs < 0) {
+    struct uthread_config config{};
+    config.quantum_usecs = quantum_usecs;
+    return uthread_init_ex(&config);
+}
+
+/**
+ * @brief Initializes the thread library with a configuration.
+ * @param config the configuration, fields left 0 take their default.
+ * @return 0 if the thread library was successfully initialized and -1 otherwise.
+ */
+int uthread_init_ex(const struct uthread_config *config) {
+    if (config == nullptr) {
+        std::cerr << INVALID_CONFIG_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->quantum_usecs < 0) {
         std::cerr << INVALID_QUANTUM_FOR_INIT_ERR << std::endl;
         return FAILURE_EXIT;
     }
-    threadsEngine = ThreadsEngine(quantum_usecs);
+    if (config->max_threads < 0) {
+        std::cerr << INVALID_MAX_THREADS_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->stack_size < 0) {
+        std::cerr << INVALID_STACK_SIZE_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->policy != UTHREAD_POLICY_RR && config->policy != UTHREAD_POLICY_MLFQ &&
+        config->policy != UTHREAD_POLICY_FAIR) {
+        std::cerr << INVALID_POLICY_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->workers < UTHREAD_WORKERS_PER_CPU) {
+        std::cerr << INVALID_WORKERS_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->trace_events < 0) {
+        std::cerr << INVALID_TRACE_EVENTS_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (config->quantum_min_usecs < 0 || config->quantum_max_usecs < 0 ||
+        (config->quantum_min_usecs == 0) != (config->quantum_max_usecs == 0) ||
+        config->quantum_min_usecs > config->quantum_max_usecs) {
+        std::cerr << INVALID_QUANTUM_BOUNDS_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    int maxThreads = config->max_threads != 0 ? config->max_threads : MAX_THREAD_NUM;
+    int stackSize = config->stack_size != 0 ? config->stack_size : STACK_SIZE;
+    int workers = config->workers == UTHREAD_WORKERS_PER_CPU ? (int) sysconf(_SC_NPROCESSORS_ONLN)
+                                                             : config->workers;
+    workers = std::max(workers, 1);
+    if (workers > 1 && config->policy != UTHREAD_POLICY_RR) {
+        std::cerr << POLICY_WITH_WORKERS_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    try {
+        threadsEngine = ThreadsEngine(config->quantum_usecs, maxThreads, stackSize, !config->cooperative,
+                                      config->wall_clock != 0, config->policy, workers);
+    } catch (const std::bad_alloc &) {
+        std::cerr << ALLOCATION_FAILURE_ERR << std::endl;
+        exit(1);
+    }
+    threadsEngine.setQuantumBounds(config->quantum_min_usecs, config->quantum_max_usecs);
+    enterCriticalSection();
+    threadsEngine.startTrace(config->trace_events);
     threadsEngine.scheduler();
+    threadsEngine.startWorkers();
+    leaveCriticalSection();
     return SUCCESS_EXIT;
 }
 
@@ -555,9 +2087,70 @@ int uthread_init(int quantum_usecs) {
  * @return the thread id.
  */
 int uthread_spawn(thread_entry_point entry_point) {
-    blockSignal();
-    int result = threadsEngine.createThread(entry_point);
-    unblockSignal();
+    return uthread_spawn_ex(entry_point, 0);
+}
+
+/**
+ * @brief Creates a new thread with a given stack size.
+ * @param entry_point the entry point of the thread.
+ * @param stack_size the stack size in bytes, 0 for the default one.
+ * @return the thread id.
+ */
+int uthread_spawn_ex(thread_entry_point entry_point, int stack_size) {
+    enterEngine();
+    int result = threadsEngine.createThread(entry_point, stack_size, UTHREAD_DEFAULT_PRIORITY);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Creates a new thread with a given priority.
+ * @param entry_point the entry point of the thread.
+ * @param priority the priority of the thread.
+ * @return the thread id.
+ */
+int uthread_spawn_prio(thread_entry_point entry_point, int priority) {
+    enterEngine();
+    int result = threadsEngine.createThread(entry_point, 0, priority);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Creates a new periodic thread.
+ * @param entry_point the entry point of the thread.
+ * @param period_quantums the quantums between the releases of the thread.
+ * @param budget_quantums the quantums the thread may run each period.
+ * @return the thread id, or -1 on failure.
+ */
+int uthread_spawn_periodic(thread_entry_point entry_point, int period_quantums, int budget_quantums) {
+    enterEngine();
+    int result = threadsEngine.spawnPeriodic(entry_point, period_quantums, budget_quantums);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Ends the job of the calling periodic thread for its current period.
+ * @return 0 on success and -1 otherwise.
+ */
+int uthread_wait_period() {
+    enterEngine();
+    int result = threadsEngine.waitPeriod();
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Sets the priority of a thread.
+ * @param tid the thread id.
+ * @param priority the new priority.
+ * @return 0 if the priority was successfully set and -1 otherwise.
+ */
+int uthread_set_priority(int tid, int priority) {
+    enterEngine();
+    int result = threadsEngine.setPriority(tid, priority);
+    leaveEngine();
     return result;
 }
 
@@ -567,9 +2160,9 @@ int uthread_spawn(thread_entry_point entry_point) {
  * @return 0 if the thread was successfully terminated and -1 otherwise.
  */
 int uthread_terminate(int tid) {
-    blockSignal();
+    enterEngine();
     int result = threadsEngine.terminateThread(tid);
-    unblockSignal();
+    leaveEngine();
     return result;
 }
 
@@ -579,9 +2172,9 @@ int uthread_terminate(int tid) {
  * @return 0 if the thread was successfully blocked and -1 otherwise.
  */
 int uthread_block(int tid) {
-    blockSignal();
+    enterEngine();
     int result = threadsEngine.blockThread(tid);
-    unblockSignal();
+    leaveEngine();
     return result;
 }
 
@@ -591,9 +2184,9 @@ int uthread_block(int tid) {
  * @return 0 if the thread was successfully resumed and -1 otherwise.
  */
 int uthread_resume(int tid) {
-    blockSignal();
+    enterEngine();
     int result = threadsEngine.resumeThread(tid);
-    unblockSignal();
+    leaveEngine();
     return result;
 }
 
@@ -603,9 +2196,385 @@ int uthread_resume(int tid) {
  * @return 0 if the thread was successfully put to sleep and -1 otherwise.
  */
 int uthread_sleep(int numQuantums) {
-    blockSignal();
+    enterEngine();
     int result = threadsEngine.sleepThread(numQuantums);
-    unblockSignal();
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Puts a thread to sleep until a total quantum starts.
+ * @param quantum the total quantum to wake up at.
+ * @return 0 if the thread was successfully put to sleep and -1 otherwise.
+ */
+int uthread_sleep_until(int quantum) {
+    enterEngine();
+    int result = threadsEngine.sleepThreadUntil(quantum);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Makes a file descriptor non-blocking, so an I/O call on it fails with EAGAIN instead of blocking the process.
+ * @param fd the file descriptor.
+ * @return 0 on success and -1 otherwise, with errno set.
+ */
+static int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return FAILURE_EXIT;
+    }
+    return (flags & O_NONBLOCK) != 0 ? SUCCESS_EXIT : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/**
+ * @brief Runs a non-blocking I/O call, parking the calling thread until the file descriptor is ready each time the call
+ * would block.
+ * @param fd the file descriptor.
+ * @param write true if the call writes, false if it reads.
+ * @param call the I/O call.
+ * @return the result of the call, or -1 if the thread could not wait.
+ */
+template<typename IoCall>
+static ssize_t retryWhenReady(int fd, bool write, IoCall call) {
+    if (setNonBlocking(fd) < 0) {
+        return FAILURE_EXIT;
+    }
+    while (true) {
+        ssize_t result = call();
+        if (result >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            return result;
+        }
+        if (errno != EINTR) {
+            enterEngine();
+            int waited = threadsEngine.waitForIo(fd, write);
+            leaveEngine();
+            if (waited == FAILURE_EXIT) {
+                return FAILURE_EXIT;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Reads from a file descriptor, running other threads while it has nothing to read.
+ * @param fd the file descriptor.
+ * @param buf the buffer to read into.
+ * @param count the buffer size in bytes.
+ * @return the number of bytes read, or -1.
+ */
+ssize_t uthread_read(int fd, void *buf, size_t count) {
+    return retryWhenReady(fd, false, [=]() { return read(fd, buf, count); });
+}
+
+/**
+ * @brief Writes to a file descriptor, running other threads while it cannot be written to.
+ * @param fd the file descriptor.
+ * @param buf the buffer to write.
+ * @param count the number of bytes to write.
+ * @return the number of bytes written, or -1.
+ */
+ssize_t uthread_write(int fd, const void *buf, size_t count) {
+    return retryWhenReady(fd, true, [=]() { return write(fd, buf, count); });
+}
+
+/**
+ * @brief Accepts a connection on a listening socket, running other threads while no connection is pending.
+ * @param sockfd the listening socket.
+ * @param addr receives the peer address, may be null.
+ * @param addrlen the size of addr, receives the size of the peer address.
+ * @return the connected socket, or -1.
+ */
+int uthread_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
+    return (int) retryWhenReady(sockfd, false, [=]() { return (ssize_t) accept(sockfd, addr, addrlen); });
+}
+
+/**
+ * @brief Initializes a mutex, unlocked.
+ * @param mutex the mutex.
+ * @return 0 if the mutex was successfully initialized and -1 otherwise.
+ */
+int uthread_mutex_init(uthread_mutex_t *mutex) {
+    if (mutex == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    *mutex = UTHREAD_MUTEX_INITIALIZER;
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Locks a mutex.
+ * @param mutex the mutex.
+ * @return 0 if the mutex was successfully locked and -1 otherwise.
+ */
+int uthread_mutex_lock(uthread_mutex_t *mutex) {
+    if (mutex == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    int unlocked = MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &unlocked, MUTEX_LOCKED, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        return SUCCESS_EXIT;
+    }
+    enterEngine();
+    threadsEngine.lockMutex(mutex);
+    leaveEngine();
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Unlocks a mutex.
+ * @param mutex the mutex.
+ * @return 0 if the mutex was successfully unlocked and -1 otherwise.
+ */
+int uthread_mutex_unlock(uthread_mutex_t *mutex) {
+    if (mutex == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    int locked = MUTEX_LOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &locked, MUTEX_UNLOCKED, false, __ATOMIC_RELEASE,
+                                    __ATOMIC_RELAXED)) {
+        return SUCCESS_EXIT;
+    }
+    enterEngine();
+    int result = threadsEngine.unlockMutex(mutex);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Initializes a condition variable.
+ * @param cond the condition variable.
+ * @return 0 if the condition variable was successfully initialized and -1 otherwise.
+ */
+int uthread_cond_init(uthread_cond_t *cond) {
+    if (cond == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    *cond = UTHREAD_COND_INITIALIZER;
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Unlocks a mutex, waits on a condition variable and locks the mutex again.
+ * @param cond the condition variable.
+ * @param mutex the mutex.
+ * @return 0 if the thread was successfully signaled and -1 otherwise.
+ */
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex) {
+    if (cond == nullptr || mutex == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    enterEngine();
+    int result = threadsEngine.waitCondition(cond, mutex);
+    leaveEngine();
+    if (result == FAILURE_EXIT) {
+        return FAILURE_EXIT;
+    }
+    return uthread_mutex_lock(mutex);
+}
+
+/**
+ * @brief Wakes up the threads waiting on a condition variable.
+ * @param cond the condition variable.
+ * @param all true to wake up all of them, false for the first one.
+ * @return 0 if the condition variable was successfully signaled and -1 otherwise.
+ */
+static int signalCondition(uthread_cond_t *cond, bool all) {
+    if (cond == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (__atomic_load_n(&cond->waiters.head, __ATOMIC_ACQUIRE) == nullptr) {
+        return SUCCESS_EXIT;
+    }
+    enterEngine();
+    threadsEngine.signalCondition(cond, all);
+    leaveEngine();
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Wakes up the first thread waiting on a condition variable.
+ * @param cond the condition variable.
+ * @return 0 if the condition variable was successfully signaled and -1 otherwise.
+ */
+int uthread_cond_signal(uthread_cond_t *cond) {
+    return signalCondition(cond, false);
+}
+
+/**
+ * @brief Wakes up all the threads waiting on a condition variable.
+ * @param cond the condition variable.
+ * @return 0 if the condition variable was successfully signaled and -1 otherwise.
+ */
+int uthread_cond_broadcast(uthread_cond_t *cond) {
+    return signalCondition(cond, true);
+}
+
+/**
+ * @brief Initializes a semaphore.
+ * @param sem the semaphore.
+ * @param value the initial value.
+ * @return 0 if the semaphore was successfully initialized and -1 otherwise.
+ */
+int uthread_sem_init(uthread_sem_t *sem, int value) {
+    if (sem == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (value < 0 || value > UTHREAD_SEM_VALUE_MAX) {
+        std::cerr << INVALID_SEM_VALUE_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    sem->value = value * SEM_UNIT;
+    sem->waiters = uthread_wait_queue{nullptr, nullptr};
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Decrements a semaphore, waiting while it is 0.
+ * @param sem the semaphore.
+ * @return 0 if the semaphore was successfully decremented and -1 otherwise.
+ */
+int uthread_sem_wait(uthread_sem_t *sem) {
+    if (sem == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+    while (value >= SEM_UNIT) {
+        if (__atomic_compare_exchange_n(&sem->value, &value, value - SEM_UNIT, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+            return SUCCESS_EXIT;
+        }
+    }
+    enterEngine();
+    threadsEngine.waitSemaphore(sem);
+    leaveEngine();
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Increments a semaphore.
+ * @param sem the semaphore.
+ * @return 0 if the semaphore was successfully incremented and -1 otherwise.
+ */
+int uthread_sem_post(uthread_sem_t *sem) {
+    if (sem == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+    while ((value & SEM_WAITERS) == 0) {
+        if (__atomic_compare_exchange_n(&sem->value, &value, value + SEM_UNIT, false, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+            return SUCCESS_EXIT;
+        }
+    }
+    enterEngine();
+    threadsEngine.postSemaphore(sem);
+    leaveEngine();
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Initializes a channel.
+ * @param chan the channel.
+ * @param capacity the number of items it holds.
+ * @return 0 if the channel was successfully initialized and -1 otherwise.
+ */
+int uthread_chan_init(uthread_chan_t *chan, int capacity) {
+    if (chan == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    if (capacity <= 0) {
+        std::cerr << INVALID_CHAN_CAPACITY_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    chan->slots = new (std::nothrow) void *[capacity];
+    if (chan->slots == nullptr) {
+        std::cerr << ALLOCATION_FAILURE_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    chan->capacity = capacity;
+    chan->first = chan->count = 0;
+    uthread_mutex_init(&chan->lock);
+    uthread_sem_init(&chan->free_slots, capacity);
+    uthread_sem_init(&chan->items, 0);
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Releases the memory of a channel.
+ * @param chan the channel.
+ * @return 0 if the channel was successfully destroyed and -1 otherwise.
+ */
+int uthread_chan_destroy(uthread_chan_t *chan) {
+    if (chan == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    delete[] chan->slots;
+    chan->slots = nullptr;
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Sends an item to a channel, waiting while it is full.
+ * @param chan the channel.
+ * @param item the item.
+ * @return 0 if the item was successfully sent and -1 otherwise.
+ */
+int uthread_chan_send(uthread_chan_t *chan, void *item) {
+    if (chan == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    uthread_sem_wait(&chan->free_slots);
+    uthread_mutex_lock(&chan->lock);
+    chan->slots[(chan->first + chan->count) % chan->capacity] = item;
+    chan->count++;
+    uthread_mutex_unlock(&chan->lock);
+    uthread_sem_post(&chan->items);
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Receives an item from a channel, waiting while it is empty.
+ * @param chan the channel.
+ * @param item receives the item.
+ * @return 0 if an item was successfully received and -1 otherwise.
+ */
+int uthread_chan_recv(uthread_chan_t *chan, void **item) {
+    if (chan == nullptr || item == nullptr) {
+        std::cerr << INVALID_SYNC_OBJECT_ERR << std::endl;
+        return FAILURE_EXIT;
+    }
+    uthread_sem_wait(&chan->items);
+    uthread_mutex_lock(&chan->lock);
+    *item = chan->slots[chan->first];
+    chan->first = (chan->first + 1) % chan->capacity;
+    chan->count--;
+    uthread_mutex_unlock(&chan->lock);
+    uthread_sem_post(&chan->free_slots);
+    return SUCCESS_EXIT;
+}
+
+/**
+ * @brief Moves the running thread to the end of the ready queue.
+ * @return 0.
+ */
+int uthread_yield() {
+    enterEngine();
+    int result = threadsEngine.yieldThread();
+    leaveEngine();
     return result;
 }
 
@@ -614,7 +2583,14 @@ int uthread_sleep(int numQuantums) {
  * @return the current thread id.
  */
 int uthread_get_tid() {
-    return (int)threadsEngine.runningThread->getThreadTid();
+    if (!threadsEngine.multiWorker) {
+        return (int)threadsEngine.running()->getThreadTid();
+    }
+    // The calling thread must not move to another worker between reading the worker and its running thread.
+    enterCriticalSection();
+    int result = (int) threadsEngine.running()->getThreadTid();
+    leaveCriticalSection();
+    return result;
 }
 
 /**
@@ -622,7 +2598,11 @@ int uthread_get_tid() {
  * @return the total number of quantums.
  */
 int uthread_get_total_quantums() {
-    return threadsEngine.totalNumOfQuantumsCount;
+    enterEngine();
+    threadsEngine.countAllTicklessQuantums();
+    int result = threadsEngine.totalNumOfQuantumsCount;
+    leaveEngine();
+    return result;
 }
 
 /**
@@ -631,8 +2611,45 @@ int uthread_get_total_quantums() {
  * @return the number of quantums of a thread.
  */
 int uthread_get_quantums(int tid) {
-    blockSignal();
+    enterEngine();
     int result = (int) threadsEngine.getThreadQuantums(tid);
-    unblockSignal();
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Gets how deep a thread has used its stack.
+ * @param tid the thread id.
+ * @return the stack high-water mark in bytes, or -1 on failure.
+ */
+int uthread_get_stack_high_water(int tid) {
+    enterEngine();
+    int result = threadsEngine.getStackHighWater(tid);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Gets the scheduling statistics of a thread, or of all the threads.
+ * @param tid the thread id, or -1 for all the threads.
+ * @param stats receives the statistics.
+ * @return 0 on success and -1 otherwise.
+ */
+int uthread_get_stats(int tid, struct uthread_stats *stats) {
+    enterEngine();
+    int result = threadsEngine.getStats(tid, stats);
+    leaveEngine();
+    return result;
+}
+
+/**
+ * @brief Writes the scheduling trace to a file.
+ * @param path the path of the file.
+ * @return 0 on success and -1 otherwise.
+ */
+int uthread_trace_dump(const char *path) {
+    enterEngine();
+    int result = threadsEngine.dumpTrace(path);
+    leaveEngine();
     return result;
 }
\ No newline at end of file
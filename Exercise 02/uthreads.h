@@ -6,12 +6,107 @@
 #ifndef _UTHREADS_H
 #define _UTHREADS_H
 
+#include <sys/types.h>
+#include <sys/socket.h>
 
 #define MAX_THREAD_NUM 100 /* maximal number of threads */
-#define STACK_SIZE 4096 /* stack size per thread (in bytes) */
+#define STACK_SIZE (256 * 1024) /* stack size per thread (in bytes), committed as the thread uses it */
+
+#define UTHREAD_PRIORITY_LEVELS 8 /* priorities range from 0 (scheduled first) to UTHREAD_PRIORITY_LEVELS - 1 */
+#define UTHREAD_DEFAULT_PRIORITY 0 /* the priority of the main thread and of threads created by uthread_spawn */
+
+#define UTHREAD_POLICY_RR 0 /* strict priorities, round robin among the READY threads of the highest priority */
+#define UTHREAD_POLICY_MLFQ 1 /* multilevel feedback queue, priorities adapt to how threads use their quantums */
+#define UTHREAD_POLICY_FAIR 2 /* fair share, the READY thread that ran the least weighted time runs next */
+
+#define UTHREAD_WORKERS_PER_CPU (-1) /* a worker kernel thread per online cpu */
+
+#define UTHREAD_SEM_VALUE_MAX 0x3fffffff /* the largest value of a semaphore */
+
+#define UTHREAD_STATS_BUCKETS 24 /* bucket b of a histogram counts [2^b, 2^(b+1)) ns, the last one also the rest */
 
 typedef void (*thread_entry_point)(void);
 
+/**
+ * @brief The threads waiting on a synchronization object, linked through the threads themselves. Managed by the
+ * library, it must not be touched by the user.
+ */
+struct uthread_wait_queue {
+    void *head;
+    void *tail;
+};
+
+/**
+ * @brief A mutex, initialized by uthread_mutex_init or UTHREAD_MUTEX_INITIALIZER.
+ */
+typedef struct {
+    int state; /* unlocked, locked, or locked with threads waiting */
+    struct uthread_wait_queue waiters;
+} uthread_mutex_t;
+
+/**
+ * @brief A condition variable, initialized by uthread_cond_init or UTHREAD_COND_INITIALIZER.
+ */
+typedef struct {
+    struct uthread_wait_queue waiters;
+} uthread_cond_t;
+
+/**
+ * @brief A counting semaphore, initialized by uthread_sem_init.
+ */
+typedef struct {
+    int value; /* the semaphore value in the high bits, the lowest bit is set while threads are waiting */
+    struct uthread_wait_queue waiters;
+} uthread_sem_t;
+
+/**
+ * @brief A bounded channel of pointers, initialized by uthread_chan_init.
+ */
+typedef struct {
+    void **slots; /* a ring buffer of capacity items, count of them starting at first */
+    int capacity;
+    int first;
+    int count;
+    uthread_mutex_t lock;
+    uthread_sem_t free_slots;
+    uthread_sem_t items;
+} uthread_chan_t;
+
+#define UTHREAD_MUTEX_INITIALIZER {0, {0, 0}}
+#define UTHREAD_COND_INITIALIZER {{0, 0}}
+
+/**
+ * @brief The configuration of the thread library, given to uthread_init_ex.
+ * Fields left 0 take their default.
+ */
+struct uthread_config {
+    int quantum_usecs; /* the length of a quantum in micro-seconds */
+    int max_threads;   /* the maximal number of concurrent threads, including the main thread (MAX_THREAD_NUM) */
+    int stack_size;    /* the stack size in bytes of threads created by uthread_spawn (STACK_SIZE) */
+    int cooperative;   /* non-zero to never preempt: no timer runs and the library raises and handles no signal */
+    int policy;        /* the scheduling policy, UTHREAD_POLICY_RR, _MLFQ or _FAIR (UTHREAD_POLICY_RR) */
+    int workers;       /* the number of kernel threads running the threads, or UTHREAD_WORKERS_PER_CPU (1) */
+    int wall_clock;    /* non-zero to measure quantums in real time instead of in the cpu time of the kernel thread */
+    int trace_events;  /* the number of scheduling events each worker keeps for uthread_trace_dump, 0 for no trace */
+    int quantum_min_usecs; /* the shortest adaptive quantum in micro-seconds, 0 for fixed quantums */
+    int quantum_max_usecs; /* the longest adaptive quantum in micro-seconds, 0 for fixed quantums */
+};
+
+/**
+ * @brief Scheduling statistics, of a thread or summed over all the threads, filled by uthread_get_stats.
+ * Times are in nanoseconds of real time.
+ */
+struct uthread_stats {
+    long long run_nsec;                  /* time spent RUNNING on a worker */
+    long long ready_nsec;                /* time spent READY, waiting for a worker */
+    long long voluntary_switches;        /* switches out by a yield, block, sleep or wait */
+    long long involuntary_switches;      /* switches out by a preemption */
+    long long deadline_misses;           /* periods a periodic thread ended without finishing its job */
+    long long switch_latency[UTHREAD_STATS_BUCKETS]; /* switches in, by the time from the scheduling decision */
+    long long preempt_lateness[UTHREAD_STATS_BUCKETS]; /* preemptions, by how late they land after the quantum ends */
+    long long quantum_usecs;             /* the quantum of its current or last dispatch, see uthread_get_stats */
+};
+
 /* External interface */
 
 
@@ -29,14 +124,53 @@ typedef void (*thread_entry_point)(void);
 */
 int uthread_init(int quantum_usecs);
 
+
+/**
+ * @brief initializes the thread library with a configuration.
+ *
+ * Behaves like uthread_init(config->quantum_usecs), with the limits given in the configuration instead of the
+ * compile-time defaults. Thread ids range from 0 to max_threads - 1, and the lowest available id is always used.
+ * In a cooperative run quantum_usecs is ignored, and a quantum only ends when the running thread yields, blocks,
+ * sleeps or terminates.
+ * Under UTHREAD_POLICY_FAIR every thread accumulates a virtual runtime, its run time weighted by its priority, and
+ * the READY thread of the least virtual runtime runs next, so the threads share the cpu in proportion to their
+ * weights: each priority gets 1.25 times the share of the next one. A new thread starts level with the threads
+ * running now, and a thread that slept or was blocked comes back a little ahead of them, not with all the time it
+ * missed. A thread that becomes READY waits for the running quantum to end, whatever its priority.
+ * With quantum_min_usecs and quantum_max_usecs, the quantum is adaptive: every dispatch sizes the quantum of the
+ * thread it starts between the two bounds, from quantum_usecs. The quantum shrinks as more threads are READY (per
+ * worker), so each of them waits about quantum_usecs for its turn, and grows up to 4 times as threads are more often
+ * switched out before their quantum expires, so the ones that use it all up are preempted less often. Quantum
+ * counts and sleeps count the quantums of any length.
+ * A quantum is measured on the cpu time of the kernel thread running the thread, or in real time with wall_clock.
+ * While the running thread has nothing to share its kernel thread with (no other READY thread, and no sleeping
+ * thread or thread waiting for I/O), its timer is disarmed and the quantums it starts are counted from the clock
+ * when they are asked for, or when another thread needs them to go on.
+ * With several workers the threads run in parallel (M:N scheduling): each worker kernel thread runs its own
+ * RUNNING thread, with a quantum measured on its own cpu time, and its own queue of READY threads, which the idle
+ * workers steal from. Every scheduling decision is still serialized by one engine lock, so the workers run threads in
+ * parallel but switch them one at a time. A thread may resume on another kernel thread after any library call or
+ * preemption, so it must not rely on kernel thread local storage. Blocking or terminating a thread running on
+ * another worker takes effect at that worker's next preemption (in a cooperative run, at the thread's next library
+ * call). Several workers only run the round robin policy, and every thread keeps the default priority.
+ * It is an error to call this function with a null config or with a negative field, other than a workers of
+ * UTHREAD_WORKERS_PER_CPU, or with only one of quantum_min_usecs and quantum_max_usecs, or a larger minimum than
+ * maximum.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_init_ex(const struct uthread_config *config);
+
 /**
  * @brief Creates a new thread, whose entry point is the function entry_point with the signature
  * void entry_point(void).
  *
  * The thread is added to the end of the READY threads list.
  * The uthread_spawn function should fail if it would cause the number of concurrent threads to exceed the
- * limit (MAX_THREAD_NUM).
- * Each thread should be allocated with a stack of size STACK_SIZE bytes.
+ * limit (MAX_THREAD_NUM, or the max_threads given to uthread_init_ex).
+ * Each thread should be allocated with a stack of size STACK_SIZE bytes (or the stack_size given to
+ * uthread_init_ex). A stack only reserves address space, its memory is committed page by page as the thread touches
+ * it, and given back when the thread is freed, so large stacks cost what the threads actually use.
  * It is an error to call this function with a null entry_point.
  *
  * @return On success, return the ID of the created thread. On failure, return -1.
@@ -44,6 +178,78 @@ int uthread_init(int quantum_usecs);
 int uthread_spawn(thread_entry_point entry_point);
 
 
+/**
+ * @brief Creates a new thread like uthread_spawn, with a stack of stack_size bytes.
+ *
+ * The library adds room for the frame of the preemption signal, which is delivered on the thread stack, and rounds
+ * the stack up to a whole number of pages. The stack is followed by an inaccessible guard page, so a thread
+ * overflowing its stack gets a SIGSEGV instead of overwriting other memory.
+ * A stack_size of 0 uses the default stack size. It is an error to call this function with a negative stack_size.
+ *
+ * @return On success, return the ID of the created thread. On failure, return -1.
+*/
+int uthread_spawn_ex(thread_entry_point entry_point, int stack_size);
+
+
+/**
+ * @brief Creates a new thread like uthread_spawn, with a given priority.
+ *
+ * The READY threads of the highest priority (the lowest number) always run first, in round robin order. A thread of
+ * a higher priority than the RUNNING thread that becomes READY runs right away, so if the new thread outranks the
+ * calling thread, a scheduling decision is made.
+ * It is an error to call this function with a priority outside of 0 to UTHREAD_PRIORITY_LEVELS - 1.
+ *
+ * @return On success, return the ID of the created thread. On failure, return -1.
+*/
+int uthread_spawn_prio(thread_entry_point entry_point, int priority);
+
+
+/**
+ * @brief Sets the priority of the thread with ID tid.
+ *
+ * Under UTHREAD_POLICY_MLFQ the priority is the thread's base priority: a thread that uses up its whole quantum is
+ * demoted one priority, a thread that blocks or sleeps before its quantum expires is boosted back one priority
+ * towards its base priority, and every thread is reset to its base priority periodically so none starves.
+ * If the change makes a READY thread outrank the RUNNING thread, a scheduling decision is made.
+ * If no thread with ID tid exists, or the priority is outside of 0 to UTHREAD_PRIORITY_LEVELS - 1, it is considered
+ * an error.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_set_priority(int tid, int priority);
+
+
+/**
+ * @brief Creates a new periodic real-time thread, released every period_quantums quantums to run for at most
+ * budget_quantums quantums before its next release.
+ *
+ * The periodic threads run ahead of every other thread, earliest deadline first, whatever the scheduling policy and
+ * the priorities. The deadline of a release is the next release, the first release is at the next quantum. A
+ * periodic thread calls uthread_wait_period when its job for the period is done, and waits for its next release. A
+ * periodic thread that uses up its budget waits for its next release too, when its last quantum ends. Every period
+ * that ends before the thread finished its job counts a deadline miss in the thread's uthread_stats. Every quantum
+ * the thread starts uses a quantum of its budget, even if it ends early.
+ * The thread is admitted only if the utilization of all the periodic threads, the sum of their budget_quantums /
+ * period_quantums, stays at 1 or below. A terminated periodic thread releases its utilization.
+ * It is an error to call this function with a period_quantums or a budget_quantums that is not positive, with a
+ * budget_quantums larger than period_quantums, if the thread is not admitted, or with several workers.
+ *
+ * @return On success, return the ID of the created thread. On failure, return -1.
+*/
+int uthread_spawn_periodic(thread_entry_point entry_point, int period_quantums, int budget_quantums);
+
+
+/**
+ * @brief Ends the job of the calling periodic thread for its current period, and waits for its next release.
+ *
+ * If the job ended after its deadline, its deadline miss has been counted, and the next job starts at once without
+ * waiting. It is an error to call this function from a thread that is not periodic.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_wait_period();
+
+
 /**
  * @brief Terminates the thread with ID tid and deletes it from all relevant control structures.
  *
@@ -96,6 +302,207 @@ int uthread_resume(int tid);
 int uthread_sleep(int num_quantums);
 
 
+/**
+ * @brief Blocks the RUNNING thread until the total quantum count reaches quantum.
+ *
+ * The thread goes back to the end of the READY queue when the quantum numbered quantum (as returned by
+ * uthread_get_total_quantums) starts. uthread_sleep(n) is the same as
+ * uthread_sleep_until(uthread_get_total_quantums() + n).
+ * Sleeping until the current quantum wakes the thread up at the next quantum, like uthread_sleep(0).
+ * It is considered an error if quantum has already passed, or if the main thread (tid == 0) calls this function.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_until(int quantum);
+
+
+/**
+ * @brief Moves the RUNNING thread to the end of the READY queue without waiting for its quantum to expire.
+ *
+ * A scheduling decision is made and a new quantum starts, as if the quantum of the calling thread had expired. If no
+ * other thread of the same or a higher priority is READY, the calling thread keeps running in the new quantum.
+ * Under UTHREAD_POLICY_MLFQ yielding does not change the priority of the calling thread. Under UTHREAD_POLICY_FAIR
+ * the calling thread gives up its lead on the next READY thread, which runs even if it ran more.
+ *
+ * @return On success, return 0.
+*/
+int uthread_yield();
+
+
+/**
+ * @brief Reads up to count bytes from the file descriptor fd into buf, like read(2), without blocking the process.
+ *
+ * The file descriptor is switched to non-blocking mode. While it has nothing to read, the calling thread is BLOCKED
+ * waiting for it (with epoll), and other threads run. A thread waiting for I/O that is also blocked with uthread_block
+ * stays BLOCKED until it is resumed, and resuming it while it waits has no effect. When no thread is READY, the
+ * process sleeps until a file descriptor is ready; each quantum it sleeps while threads are sleeping is counted.
+ * It is considered an error if another thread already waits to read from fd.
+ *
+ * @return The number of bytes read. On failure, return -1 with errno set as read(2) sets it.
+*/
+ssize_t uthread_read(int fd, void *buf, size_t count);
+
+
+/**
+ * @brief Writes up to count bytes from buf to the file descriptor fd, like write(2), without blocking the process.
+ *
+ * Waits like uthread_read, until fd can be written to.
+ * It is considered an error if another thread already waits to write to fd.
+ *
+ * @return The number of bytes written. On failure, return -1 with errno set as write(2) sets it.
+*/
+ssize_t uthread_write(int fd, const void *buf, size_t count);
+
+
+/**
+ * @brief Accepts a connection on the listening socket sockfd, like accept(2), without blocking the process.
+ *
+ * Waits like uthread_read, until a connection is pending.
+ * It is considered an error if another thread already waits to accept on sockfd, or to read from it.
+ *
+ * @return The connected socket. On failure, return -1 with errno set as accept(2) sets it.
+*/
+int uthread_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
+
+
+/**
+ * @brief Initializes a mutex, unlocked.
+ *
+ * Locking an unlocked mutex and unlocking a mutex no thread waits for make no system call.
+ * It is an error to call this function with a null mutex, like all the synchronization functions.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_init(uthread_mutex_t *mutex);
+
+
+/**
+ * @brief Locks a mutex.
+ *
+ * If the mutex is locked, the calling thread is BLOCKED waiting for it, and other threads run. The waiting threads get
+ * the mutex in the order they started waiting: unlocking hands it over directly to the first of them, which becomes
+ * READY with the mutex locked. A waiting thread that is also blocked with uthread_block gets the mutex all the same,
+ * and stays BLOCKED until it is resumed. Locking a mutex the calling thread holds deadlocks it.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock(uthread_mutex_t *mutex);
+
+
+/**
+ * @brief Unlocks a mutex, handing it over to the first thread waiting for it if any.
+ *
+ * It is an error to unlock a mutex that is not locked.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock(uthread_mutex_t *mutex);
+
+
+/**
+ * @brief Initializes a condition variable.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_cond_init(uthread_cond_t *cond);
+
+
+/**
+ * @brief Unlocks a mutex the calling thread holds and waits on a condition variable, then locks the mutex again.
+ *
+ * Waits like uthread_mutex_lock, until the condition variable is signaled. The calling thread must recheck its
+ * condition once it returns. It is an error to call this function with an unlocked mutex.
+ *
+ * @return On success, return 0 with the mutex locked. On failure, return -1.
+*/
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex);
+
+
+/**
+ * @brief Wakes up the first thread waiting on a condition variable, if any. Makes no system call if none is waiting.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_cond_signal(uthread_cond_t *cond);
+
+
+/**
+ * @brief Wakes up all the threads waiting on a condition variable. Makes no system call if none is waiting.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_cond_broadcast(uthread_cond_t *cond);
+
+
+/**
+ * @brief Initializes a semaphore.
+ *
+ * It is an error to call this function with a value outside of 0 to UTHREAD_SEM_VALUE_MAX.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_sem_init(uthread_sem_t *sem, int value);
+
+
+/**
+ * @brief Decrements a semaphore, waiting while it is 0.
+ *
+ * Waits like uthread_mutex_lock, until uthread_sem_post hands the unit it adds over to the calling thread. Makes no
+ * system call if the semaphore is positive.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_sem_wait(uthread_sem_t *sem);
+
+
+/**
+ * @brief Increments a semaphore, or hands the unit over to the first thread waiting on it if any. Makes no system call
+ * if no thread is waiting.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_sem_post(uthread_sem_t *sem);
+
+
+/**
+ * @brief Initializes a channel, holding up to capacity items.
+ *
+ * It is an error to call this function with a non-positive capacity.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_chan_init(uthread_chan_t *chan, int capacity);
+
+
+/**
+ * @brief Releases the memory of a channel no thread uses anymore.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_chan_destroy(uthread_chan_t *chan);
+
+
+/**
+ * @brief Sends an item to a channel, waiting while it is full.
+ *
+ * Items are received in the order they are sent. Waits like uthread_mutex_lock, and makes no system call if the
+ * channel is neither full nor contended.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_chan_send(uthread_chan_t *chan, void *item);
+
+
+/**
+ * @brief Receives an item from a channel, waiting while it is empty.
+ *
+ * Waits like uthread_mutex_lock, and makes no system call if the channel is neither empty nor contended.
+ *
+ * @return On success, return 0 with the item in *item. On failure, return -1.
+*/
+int uthread_chan_recv(uthread_chan_t *chan, void **item);
+
+
 /**
  * @brief Returns the thread ID of the calling thread.
  *
@@ -127,4 +534,43 @@ int uthread_get_total_quantums();
 int uthread_get_quantums(int tid);
 
 
+/**
+ * @brief Gets the scheduling statistics of the thread with ID tid, or of all the threads if tid is -1.
+ *
+ * The statistics of all the threads include the threads that have terminated. The time the running threads are
+ * in their current quantum is included. A preemption that lands inside a library call runs at its end, and its
+ * lateness includes the rest of the call. The quantum_usecs of a thread is the quantum of its current or last
+ * dispatch, 0 before it first runs, and the one of all the threads is the current quantum of the calling thread.
+ * If no thread with ID tid exists it is considered an error.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_get_stats(int tid, struct uthread_stats *stats);
+
+
+/**
+ * @brief Gets the stack high-water mark of the thread with ID tid: how deep it has used its stack so far.
+ *
+ * The mark is measured from the pages of the stack that are committed, so it is rounded up to whole pages and
+ * includes the frames of the preemption signals delivered on the stack. The top page of a stack is always counted.
+ * If no thread with ID tid exists, or tid is 0 (the main thread runs on the process stack), it is considered an
+ * error.
+ *
+ * @return On success, return the high-water mark in bytes. On failure, return -1.
+*/
+int uthread_get_stack_high_water(int tid);
+
+
+/**
+ * @brief Writes the scheduling trace to a file, for tools/trace_to_chrome.
+ *
+ * With a trace_events given to uthread_init_ex, every worker records its last trace_events scheduling events in a
+ * ring buffer: the spawns, switches in and out with their reason, sleeps, resumes and timer expiries, each stamped
+ * with the cpu's time stamp counter. It is an error to call this function without a trace.
+ *
+ * @return On success, return 0. On failure, return -1.
+*/
+int uthread_trace_dump(const char *path);
+
+
 #endif
@@ -0,0 +1,63 @@
+#include "wait_queue.h"
+#include "thread.h"
+
+/**
+ * @brief Constructor for the WaitQueue class.
+ * @param queue the queue of a synchronization object.
+ */
+WaitQueue::WaitQueue(uthread_wait_queue &queue) : queue(queue) {}
+
+/**
+ * @brief Appends a thread.
+ * @param thread a thread that is not waiting.
+ */
+void WaitQueue::push(Thread *thread) {
+    auto tail = static_cast<Thread *>(queue.tail);
+    thread->waitQueue = &queue;
+    thread->waitPrev = tail;
+    thread->waitNext = nullptr;
+    if (tail != nullptr) {
+        tail->waitNext = thread;
+    } else {
+        __atomic_store_n(&queue.head, thread, __ATOMIC_RELEASE);
+    }
+    queue.tail = thread;
+}
+
+/**
+ * @brief Removes the first thread.
+ * @return the thread, the queue must not be empty.
+ */
+Thread *WaitQueue::pop() {
+    auto thread = static_cast<Thread *>(queue.head);
+    remove(thread);
+    return thread;
+}
+
+/**
+ * @brief Checks if the queue is empty.
+ * @return true if no thread is waiting.
+ */
+bool WaitQueue::empty() const {
+    return queue.head == nullptr;
+}
+
+/**
+ * @brief Removes a thread from the queue it waits in.
+ * @param thread a waiting thread.
+ */
+void WaitQueue::remove(Thread *thread) {
+    uthread_wait_queue &queue = *thread->waitQueue;
+    if (thread->waitPrev != nullptr) {
+        thread->waitPrev->waitNext = thread->waitNext;
+    } else {
+        __atomic_store_n(&queue.head, thread->waitNext, __ATOMIC_RELEASE);
+    }
+    if (thread->waitNext != nullptr) {
+        thread->waitNext->waitPrev = thread->waitPrev;
+    } else {
+        queue.tail = thread->waitPrev;
+    }
+    thread->waitQueue = nullptr;
+    thread->waitPrev = thread->waitNext = nullptr;
+}
@@ -0,0 +1,50 @@
+#ifndef WAIT_QUEUE_H
+#define WAIT_QUEUE_H
+
+#include "uthreads.h"
+
+class Thread;
+
+/**
+ * @brief The WaitQueue class operates on the FIFO queue of threads waiting on a synchronization object, which lives in
+ * the object itself. The queue is intrusive, linked through the waitPrev and waitNext of the threads, so waiting
+ * allocates nothing and a terminated thread leaves its queue in O(1).
+ * The head is read without the engine lock by the fast paths that check for waiters, so it is written atomically.
+ */
+class WaitQueue {
+public:
+    /**
+     * @brief Constructor for the WaitQueue class.
+     * @param queue the queue of a synchronization object.
+     */
+    explicit WaitQueue(uthread_wait_queue &queue);
+
+    /**
+     * @brief Appends a thread.
+     * @param thread a thread that is not waiting.
+     */
+    void push(Thread *thread);
+
+    /**
+     * @brief Removes the first thread.
+     * @return the thread, the queue must not be empty.
+     */
+    Thread *pop();
+
+    /**
+     * @brief Checks if the queue is empty.
+     * @return true if no thread is waiting.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Removes a thread from the queue it waits in.
+     * @param thread a waiting thread.
+     */
+    static void remove(Thread *thread);
+
+private:
+    uthread_wait_queue &queue;
+};
+
+#endif // WAIT_QUEUE_H
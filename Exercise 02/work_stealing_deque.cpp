@@ -0,0 +1,83 @@
+#include "work_stealing_deque.h"
+
+#define INITIAL_CAPACITY 64
+
+/**
+ * @brief Constructor for the WorkStealingDeque class, with an empty deque.
+ */
+WorkStealingDeque::WorkStealingDeque() : top(0), bottom(0),
+                                         buffer(new Buffer{INITIAL_CAPACITY,
+                                                           new std::atomic<Thread *>[INITIAL_CAPACITY]}) {}
+
+/**
+ * @brief Destructor for the WorkStealingDeque class.
+ */
+WorkStealingDeque::~WorkStealingDeque() {
+    retired.push_back(buffer.load(std::memory_order_relaxed));
+    for (Buffer *old: retired) {
+        delete[] old->slots;
+        delete old;
+    }
+}
+
+/**
+ * @brief Appends a thread at the bottom, may only be called by the owner.
+ * @param thread the thread.
+ */
+void WorkStealingDeque::push(Thread *thread) {
+    long last = bottom.load(std::memory_order_relaxed);
+    long first = top.load(std::memory_order_acquire);
+    Buffer *current = buffer.load(std::memory_order_relaxed);
+    if (last - first > current->capacity - 1) {
+        current = grow(current, first, last);
+    }
+    current->slots[last & (current->capacity - 1)].store(thread, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(last + 1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Takes the thread at the top, may be called by any worker.
+ * @return the thread, or nullptr if the deque is empty.
+ */
+Thread *WorkStealingDeque::steal() {
+    while (true) {
+        long first = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long last = bottom.load(std::memory_order_acquire);
+        if (first >= last) {
+            return nullptr;
+        }
+        Buffer *current = buffer.load(std::memory_order_acquire);
+        Thread *thread = current->slots[first & (current->capacity - 1)].load(std::memory_order_relaxed);
+        if (top.compare_exchange_strong(first, first + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return thread;
+        } // else another worker took it first, try the next one.
+    }
+}
+
+/**
+ * @brief Checks if the deque is empty, without synchronizing with concurrent pushes and steals.
+ * @return true if the deque looked empty.
+ */
+bool WorkStealingDeque::empty() const {
+    return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Replaces the buffer with one twice as large, holding the same threads.
+ * @param old the current buffer.
+ * @param first the top index.
+ * @param last the bottom index.
+ * @return the new buffer.
+ */
+WorkStealingDeque::Buffer *WorkStealingDeque::grow(Buffer *old, long first, long last) {
+    auto grown = new Buffer{2 * old->capacity, new std::atomic<Thread *>[2 * old->capacity]};
+    for (long i = first; i < last; i++) {
+        grown->slots[i & (grown->capacity - 1)].store(old->slots[i & (old->capacity - 1)].load(
+                std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    retired.push_back(old);
+    buffer.store(grown, std::memory_order_release);
+    return grown;
+}
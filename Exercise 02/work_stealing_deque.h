@@ -0,0 +1,77 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <vector>
+
+class Thread;
+
+/**
+ * @brief The WorkStealingDeque class is a per-worker FIFO deque of ready threads. It has the push and steal of a
+ * Chase-Lev deque (Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models",
+ * PPoPP 2013), but not its owner pop at the bottom.
+ * Only its owner worker pushes, at the bottom. Threads are taken from the top, by the owner as well as by the workers
+ * stealing from it, so every worker runs its ready threads in FIFO order, like the single worker ready queue.
+ * The engine only pushes and takes under its engine lock, which serializes every scheduling decision, so the deques
+ * spread the ready threads over the workers but do not make scheduling itself concurrent. empty() is the one call
+ * made without the lock, by idle workers polling for work.
+ */
+class WorkStealingDeque {
+public:
+    /**
+     * @brief Constructor for the WorkStealingDeque class, with an empty deque.
+     */
+    WorkStealingDeque();
+
+    /**
+     * @brief Destructor for the WorkStealingDeque class.
+     */
+    ~WorkStealingDeque();
+
+    WorkStealingDeque(const WorkStealingDeque &other) = delete;
+
+    WorkStealingDeque &operator=(const WorkStealingDeque &other) = delete;
+
+    /**
+     * @brief Appends a thread at the bottom, may only be called by the owner.
+     * @param thread the thread.
+     */
+    void push(Thread *thread);
+
+    /**
+     * @brief Takes the thread at the top, may be called by any worker.
+     * @return the thread, or nullptr if the deque is empty.
+     */
+    Thread *steal();
+
+    /**
+     * @brief Checks if the deque is empty, without synchronizing with concurrent pushes and steals.
+     * @return true if the deque looked empty.
+     */
+    bool empty() const;
+
+private:
+    /**
+     * @brief A circular array of slots, its capacity is a power of 2.
+     */
+    struct Buffer {
+        long capacity;
+        std::atomic<Thread *> *slots;
+    };
+
+    std::atomic<long> top;
+    std::atomic<long> bottom;
+    std::atomic<Buffer *> buffer;
+    std::vector<Buffer *> retired; // grown out of, kept until destruction as a thief may still read them.
+
+    /**
+     * @brief Replaces the buffer with one twice as large, holding the same threads.
+     * @param old the current buffer.
+     * @param first the top index.
+     * @param last the bottom index.
+     * @return the new buffer.
+     */
+    Buffer *grow(Buffer *old, long first, long last);
+};
+
+#endif // WORK_STEALING_DEQUE_H